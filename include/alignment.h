@@ -0,0 +1,175 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+namespace speakerbox {
+
+// Vented-box alignment families (Thiele/Small, Keele)
+enum class Alignment {
+    QB3,   // Quasi-Butterworth 3rd order, Qt below B4
+    SBB4,  // Sub-Butterworth 4th order, Qt below B4
+    B4,    // Butterworth 4th order (single point)
+    C4,    // Chebyshev 4th order, Qt above B4
+    BB4    // Butterworth-Bessel blend, Qt below B4
+};
+
+struct AlignmentPoint {
+    double qt;
+    double h;  // fb / fs
+    double alpha;  // Vas / Vb
+};
+
+namespace alignment {
+
+constexpr std::size_t kFamilies = 5;
+constexpr std::size_t kRawSamples = 257;
+constexpr std::size_t kTableSize = 64;
+// Tabulated leakage losses as 1/QL; 0 is lossless
+constexpr std::array<double, 6> kInvQL = {0.0, 1.0 / 15.0, 1.0 / 10.0, 1.0 / 7.0, 1.0 / 5.0, 1.0 / 3.0};
+
+// Normalized high-pass denominator s^4 + a1 s^3 + a2 s^2 + a3 s + 1
+struct Coefficients {
+    double a1, a2, a3;
+};
+
+struct Table {
+    double qt_min;
+    double qt_step;
+    std::array<AlignmentPoint, kTableSize> points;
+};
+
+constexpr double csqrt(double x) {
+    if (x <= 0.0) return 0.0;
+    double r = x < 1.0 ? 1.0 : x;
+    for (int i = 0; i < 64; ++i) {
+        double next = 0.5 * (r + x / r);
+        if (next >= r) break;
+        r = next;
+    }
+    return r;
+}
+
+// Small, "Vented-Box Loudspeaker Systems", with leakage losses only (QA, QP -> infinity)
+constexpr Coefficients ventedCoefficients(double qt, double h, double alpha, double inv_ql) {
+    double u = csqrt(h);
+    return {1.0 / (u * qt) + u * inv_ql,
+            inv_ql / qt + (alpha + 1.0 + h * h) / h,
+            u / qt + inv_ql / u};
+}
+
+// Inverse of ventedCoefficients: solve -L u^4 + a1 u^3 - a3 u + L = 0 for u = sqrt(h)
+constexpr AlignmentPoint solve(const Coefficients& c, double inv_ql) {
+    double u = csqrt(c.a3 / c.a1);
+    for (int i = 0; i < 32; ++i) {
+        double f = -inv_ql * u * u * u * u + c.a1 * u * u * u - c.a3 * u + inv_ql;
+        double df = -4.0 * inv_ql * u * u * u + 3.0 * c.a1 * u * u - c.a3;
+        if (df == 0.0) break;
+        u -= f / df;
+    }
+    double q = u * (c.a1 - u * inv_ql);  // 1/Qt
+    double h = u * u;
+    return {1.0 / q, h, h * (c.a2 - q * inv_ql) - 1.0 - h * h};
+}
+
+// Coefficients of a family member; t in [0, 1] sweeps away from B4
+constexpr Coefficients familyCoefficients(Alignment family, double t) {
+    constexpr double b4_a1 = csqrt(4.0 + 2.0 * csqrt(2.0));
+    switch (family) {
+        case Alignment::QB3: {
+            // |H|^2 denominator terms in w^6 and w^4 vanish
+            double a1 = b4_a1 * (1.0 + t);
+            double a2 = a1 * a1 / 2.0;
+            return {a1, a2, (a2 * a2 + 2.0) / (2.0 * a1)};
+        }
+        case Alignment::SBB4: {
+            // |H|^2 denominator terms in w^6 and w^2 vanish
+            double a1 = b4_a1 * (1.0 + t);
+            return {a1, a1 * a1 / 2.0, a1};
+        }
+        case Alignment::B4:
+            return {b4_a1, 2.0 + csqrt(2.0), b4_a1};
+        case Alignment::C4: {
+            // Chebyshev poles: -x sin(th) +/- j sqrt(1 + x^2) cos(th), th = pi/8, 3pi/8
+            constexpr double s1 = 0.38268343236508977, s2 = 0.92387953251128674;
+            double x = 0.25 + 7.75 * (1.0 - t) * (1.0 - t) * (1.0 - t);
+            double y = csqrt(1.0 + x * x);
+            double sa = x * s1, wa = y * s2, sb = x * s2, wb = y * s1;
+            double ra = sa * sa + wa * wa, rb = sb * sb + wb * wb;
+            double g = csqrt(csqrt(ra * rb));
+            // Low-pass b3, b2, b1 normalized to b0 = 1, mirrored to high-pass
+            return {(2.0 * sa * rb + 2.0 * sb * ra) / (g * g * g),
+                    (ra + rb + 4.0 * sa * sb) / (g * g),
+                    (2.0 * sa + 2.0 * sb) / g};
+        }
+        case Alignment::BB4: {
+            // Blend from B4 to the normalized Bessel polynomial s^4 + 10s^3 + 45s^2 + 105s + 105
+            constexpr double g = csqrt(csqrt(105.0));
+            constexpr Coefficients bessel = {105.0 / (g * g * g), 45.0 / (g * g), 10.0 / g};
+            return {b4_a1 + t * (bessel.a1 - b4_a1),
+                    2.0 + csqrt(2.0) + t * (bessel.a2 - 2.0 - csqrt(2.0)),
+                    b4_a1 + t * (bessel.a3 - b4_a1)};
+        }
+    }
+    return {b4_a1, 2.0 + csqrt(2.0), b4_a1};
+}
+
+// Family sampled along t, then resampled onto a uniform Qt grid
+constexpr Table makeTable(Alignment family, double inv_ql) {
+    std::array<AlignmentPoint, kRawSamples> raw{};
+    for (std::size_t i = 0; i < kRawSamples; ++i) {
+        double t = static_cast<double>(i) / (kRawSamples - 1);
+        raw[i] = solve(familyCoefficients(family, t), inv_ql);
+    }
+    if (raw[0].qt > raw[kRawSamples - 1].qt) {  // Qt is monotonic in t; order it ascending
+        for (std::size_t i = 0; i < kRawSamples / 2; ++i) {
+            AlignmentPoint p = raw[i];
+            raw[i] = raw[kRawSamples - 1 - i];
+            raw[kRawSamples - 1 - i] = p;
+        }
+    }
+
+    Table table{};
+    table.qt_min = raw[0].qt;
+    table.qt_step = (raw[kRawSamples - 1].qt - raw[0].qt) / (kTableSize - 1);
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < kTableSize; ++i) {
+        double qt = table.qt_min + table.qt_step * i;
+        while (k + 2 < kRawSamples && raw[k + 1].qt < qt) ++k;
+        double span = raw[k + 1].qt - raw[k].qt;
+        double f = span > 0.0 ? (qt - raw[k].qt) / span : 0.0;
+        if (f < 0.0) f = 0.0;
+        if (f > 1.0) f = 1.0;
+        table.points[i] = {qt, raw[k].h + f * (raw[k + 1].h - raw[k].h),
+                           raw[k].alpha + f * (raw[k + 1].alpha - raw[k].alpha)};
+    }
+    return table;
+}
+
+using Tables = std::array<std::array<Table, kInvQL.size()>, kFamilies>;
+
+constexpr Tables makeTables() {
+    Tables tables{};
+    for (std::size_t f = 0; f < kFamilies; ++f) {
+        for (std::size_t q = 0; q < kInvQL.size(); ++q) {
+            tables[f][q] = makeTable(static_cast<Alignment>(f), kInvQL[q]);
+        }
+    }
+    return tables;
+}
+
+const Table& table(Alignment family, std::size_t ql_index);
+
+}  // namespace alignment
+
+// Interpolated on Qt and 1/QL; ql <= 0 means lossless. in_range is false when qts was clamped.
+// slope receives dh/dQts and dalpha/dQts of the interpolant (zero where clamped)
+AlignmentPoint lookupAlignment(Alignment family, double qts, double ql, bool* in_range = nullptr, AlignmentPoint* slope = nullptr);
+
+// QB3 below the B4 Qt, C4 above
+Alignment recommendAlignment(double qts, double ql);
+
+std::string alignmentName(Alignment family);
+
+}  // namespace speakerbox
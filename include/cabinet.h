@@ -0,0 +1,46 @@
+#pragma once
+
+#include "dual.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace speakerbox {
+
+// How the box is built. Calculator reads these from its options under the
+// keys listed in optionKeys(); anything missing keeps its default.
+struct CabinetConstraints {
+    double panel;  // mm, sheet thickness
+    int braces;  // Window braces across the width x depth section
+    double brace_width;  // mm, rail left around each window
+    double cutout;  // mm, driver cutout; 0 takes it from Sd
+    double max_width, max_height, max_depth;  // cm outside, 0 for no limit
+    double ratio_width, ratio_height, ratio_depth;  // Preferred inside proportions
+
+    CabinetConstraints();  // 18 mm panels, one 50 mm window brace, 1 : 1.6 : 0.6
+    ~CabinetConstraints() = default;
+
+    static const std::vector<std::string>& optionKeys();  // panel, braces, brace_width, cutout, max_width, max_height, max_depth
+    static CabinetConstraints fromOptions(const std::map<std::string, double>& options);
+};
+
+template <typename T>
+struct BasicCabinet {
+    T width, height, depth;  // cm inside
+    T outer_width, outer_height, outer_depth;  // cm
+    T bracing;  // liters taken by the braces
+    bool fits;  // False if the volume needs more than the maximum size; the box is then that maximum,
+                // or all zero when a limit leaves no room inside the panels
+    bool baffle_fits;  // False if the cutout is wider than the maximum baffle; that side is then at the maximum
+};
+
+// Inside dimensions holding net_volume of air after the displaced liters and
+// the braces. The box keeps the preferred proportions except where a side is
+// held at a bound: the baffle no narrower or shorter than the cutout (cm),
+// nothing past the maximum outside size. Bisection on the common scale, then
+// one Newton step in T so Gradient results carry exact derivatives.
+// Instantiated for double, float and Gradient.
+template <typename T>
+BasicCabinet<T> solveCabinet(T net_volume, T displaced, T cutout, const CabinetConstraints& constraints);
+
+}  // namespace speakerbox
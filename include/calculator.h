@@ -1,29 +1,50 @@
 #pragma once
 
+#include <array>
 #include <cmath>
+#include <complex>
 #include <string>
 #include <vector>
 #include <map>
+#include "alignment.h"
+#include "cabinet.h"
+#include "dual.h"
 
 namespace speakerbox {
 
-struct TSParameters {
-    double fs;  // Hz
-    double qts;
-    double vas;  // liters
-    double re;  // ohms
-    double sd;  // cm²
-    double xmax;  // mm
-    double vd;  // liters (Sd * Xmax / 1000)
-    double le;  // mH
-    double cms;  // m/N
-    double mms;  // grams
-    double bl;  // Tm
-
-    TSParameters();  // Default ctor
-    ~TSParameters() = default;
+// Enclosure math is written once over the scalar type T: double for normal
+// use, float, or Gradient to carry derivatives for sensitivity analysis
+template <typename T>
+struct BasicTSParameters {
+    T fs;  // Hz
+    T qts;
+    T vas;  // liters
+    T re;  // ohms
+    T sd;  // cm²
+    T xmax;  // mm
+    T vd;  // liters (Sd * Xmax / 1000)
+    T le;  // mH
+    T cms;  // m/N
+    T mms;  // grams
+    T bl;  // Tm
+
+    BasicTSParameters() : fs(0.0), qts(0.0), vas(0.0), re(0.0), sd(0.0), xmax(0.0), vd(0.0), le(0.0), cms(0.0), mms(0.0), bl(0.0) {}
+    ~BasicTSParameters() = default;
 };
 
+using TSParameters = BasicTSParameters<double>;
+
+constexpr std::size_t kParameterCount = 11;  // TSParameters fields
+using Gradient = Dual<kParameterCount>;  // Derivatives w.r.t. each field, in declaration order
+
+// Copy with Cms, Mms and Bl filled in from Fs, Qts, Vas, Sd and Re wherever
+// they are zero; Qms is taken as 5 when Bl has to be derived
+TSParameters completeParameters(const TSParameters& params);
+
+// Mechanical resistance Rms (kg/s) of a completed set: Qms is what Qts leaves
+// after the electrical Q, or 5 when the sheet's numbers leave nothing
+double mechanicalResistance(const TSParameters& full);
+
 enum class EnclosureType {
     Sealed,
     Ported,
@@ -32,39 +53,90 @@ enum class EnclosureType {
     PassiveRadiator
 };
 
-struct EnclosureResult {
+template <typename T>
+struct BasicEnclosureResult {
     std::string type;
-    double vb;  // liters
-    double fc_or_fb;  // Hz
+    T vb;  // liters of air, net of everything inside the box
+    T fc_or_fb;  // Hz
     std::string freq_response;
-    double port_length;  // cm (if applicable)
-    double port_diameter;  // cm
-    double air_velocity;  // m/s (basic)
-    double width, height, depth;  // cm, golden ratio
+    T port_length;  // cm (if applicable)
+    T port_diameter;  // cm
+    T air_velocity;  // m/s (basic)
+    T alpha;  // Vas/Vb
+    T ql;  // leakage Q (vented)
+    T width, height, depth;  // cm inside
+    T outer_width, outer_height, outer_depth;  // cm, panels included
+    T displacement;  // liters: driver, port and bracing
     bool within_xmax;
     std::vector<std::string> warnings;
 };
 
+using EnclosureResult = BasicEnclosureResult<double>;
+
+// Warnings the box sizing adds when the size limits bind
+constexpr const char* kOversizeWarning = "Volume does not fit the maximum box size";
+constexpr const char* kCutoutWarning = "Driver cutout does not fit the maximum baffle size";
+
+// Exact partial derivatives of the main outputs, indexed like Gradient
+struct Sensitivity {
+    using Row = std::array<double, kParameterCount>;
+    Row vb, fc_or_fb, port_length, width, height, depth;
+};
+
+// Rational function of s (rad/s), coefficients in ascending powers
+struct TransferFunction {
+    std::vector<double> num;
+    std::vector<double> den;
+
+    std::complex<double> evaluate(double freq) const;  // freq in Hz
+};
+
 class Calculator {
 public:
     Calculator();
     ~Calculator();
 
-    EnclosureResult calculate(const TSParameters& params, EnclosureType type, const std::map<std::string, double>& options = {});
+    // Instantiated for double, float and Gradient
+    template <typename T>
+    BasicEnclosureResult<T> calculate(const BasicTSParameters<T>& params, EnclosureType type, const std::map<std::string, double>& options = {});
+    // The two halves of calculate(), instantiated for double: the alignment
+    // (type, Vb, tuning, port length) from Fs, Qts, Vas and the tuning options,
+    // then what follows from it with Sd, Xmax, Vd and the cabinet options
+    // (port air velocity, excursion, dimensions)
+    template <typename T>
+    BasicEnclosureResult<T> calculateTuning(const BasicTSParameters<T>& params, EnclosureType type, const std::map<std::string, double>& options = {});
+    template <typename T>
+    void calculateGeometry(BasicEnclosureResult<T>& result, const BasicTSParameters<T>& params, const std::map<std::string, double>& options = {});
+    // One Gradient pass: the result and its derivatives w.r.t. every parameter
+    EnclosureResult calculateSensitivity(const TSParameters& params, EnclosureType type, Sensitivity& sensitivity,
+                                         const std::map<std::string, double>& options = {});
+    // Splits the rows across hardware threads; results keep the input order.
+    // With sensitivities, every row is a Gradient pass instead.
+    std::vector<EnclosureResult> calculateBatch(const std::vector<TSParameters>& params, EnclosureType type, const std::map<std::string, double>& options = {},
+                                                std::vector<Sensitivity>* sensitivities = nullptr);
 
     std::string recommendType(double qts) const;
 
+    TransferFunction transferFunction(const TSParameters& params, const EnclosureResult& result) const;
+
 private:
-    EnclosureResult calculateSealed(const TSParameters& params, double desired_qtc);
-    EnclosureResult calculatePorted(const TSParameters& params, double desired_fb);
-    EnclosureResult calculateBandpass(const TSParameters& params, double s);
-    EnclosureResult calculateTransmissionLine(const TSParameters& params, double tr);
-    EnclosureResult calculatePassiveRadiator(const TSParameters& params, double delta);
-
-    void applyGoldenRatio(double vb, double& width, double& height, double& depth) const;
-    double calculatePortAirVelocity(double sd, double xmax, double fb) const;  // Basic
-    bool checkExcursion(double xmax) const;  // Placeholder
-    double subtractDisplacements(double vb, const TSParameters& params, double port_vol = 0.0) const;
+    template <typename T>
+    BasicEnclosureResult<T> calculateSealed(const BasicTSParameters<T>& params, double desired_qtc);
+    template <typename T>
+    BasicEnclosureResult<T> calculatePorted(const BasicTSParameters<T>& params, Alignment alignment, double ql);
+    template <typename T>
+    BasicEnclosureResult<T> calculateBandpass(const BasicTSParameters<T>& params, double s);
+    template <typename T>
+    BasicEnclosureResult<T> calculateTransmissionLine(const BasicTSParameters<T>& params, double tr);
+    template <typename T>
+    BasicEnclosureResult<T> calculatePassiveRadiator(const BasicTSParameters<T>& params, double delta);
+
+    template <typename T>
+    void sizeCabinet(BasicEnclosureResult<T>& result, const BasicTSParameters<T>& params, const CabinetConstraints& constraints) const;
+    template <typename T>
+    T calculatePortAirVelocity(T sd, T xmax, T fb) const;  // Basic
+    template <typename T>
+    bool checkExcursion(T xmax) const;  // Placeholder
 };
 
 }  // namespace speakerbox
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "calculator.h"
 #include <string>
 #include <map>
 #include <filesystem>
 #include <fstream>
+#include <istream>
+#include <vector>
 
 namespace speakerbox {
 
@@ -19,11 +22,27 @@ public:
 
     void loadTSParameters(TSParameters& params);
     void saveTSParameters(const TSParameters& params);
+    // Adds the CabinetConstraints keys present in the file to calculator options
+    void loadCabinetOptions(std::map<std::string, double>& options) const;
 
 private:
     std::map<std::string, std::string> data_;
 };
 
+// Streams T/S parameter rows from CSV; the header names the fields (fs,qts,vas,...), unknown columns are skipped
+class TSParametersReader {
+public:
+    explicit TSParametersReader(std::istream& in);
+
+    bool ok() const { return ok_; }
+    std::size_t read(std::vector<TSParameters>& rows, std::size_t max_rows);  // Replaces rows; 0 at end
+
+private:
+    std::istream& in_;
+    std::vector<double TSParameters::*> columns_;
+    bool ok_;
+};
+
 void initDataDir();
 
 }  // namespace speakerbox
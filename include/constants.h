@@ -0,0 +1,9 @@
+#pragma once
+
+namespace speakerbox {
+
+// Air at about 20 C, shared by every acoustic model
+constexpr double AIR_DENSITY = 1.18;  // kg/m^3
+constexpr double SPEED_SOUND = 343.0;  // m/s
+
+}  // namespace speakerbox
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "calculator.h"
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace speakerbox {
+
+enum class FilterKind {
+    LowPass,
+    HighPass
+};
+
+// Preferred-number series for component values
+enum class ESeries {
+    E6 = 6,
+    E12 = 12,
+    E24 = 24
+};
+
+// Nearest preferred value on a log scale
+double preferredValue(double value, ESeries series);
+
+// Voltage-driven ladder ahead of the driver. ladder[0] sits at the amplifier
+// and elements alternate series / shunt: inductors in series and capacitors
+// in shunt for a low-pass, the other way round for a high-pass. The L-pad
+// (pad_series, then pad_shunt across the driver side) and the Zobel (zobel_r
+// and zobel_c in series, across the driver) are left out when zero.
+struct CrossoverDesign {
+    FilterKind kind;
+    std::vector<double> ladder;  // H and F
+    double pad_series, pad_shunt;  // ohms
+    double zobel_r;  // ohms
+    double zobel_c;  // F
+};
+
+struct CrossoverTarget {
+    FilterKind kind;
+    int order;  // 1-4: Linkwitz-Riley for even orders, Butterworth for odd
+    double frequency;  // Hz
+    double level;  // dB relative to the driver; below 0 adds an L-pad
+    bool zobel;
+    ESeries reactive_series;  // Inductors and capacitors
+    ESeries resistor_series;
+
+    CrossoverTarget();  // LR4 low-pass at 2 kHz with a Zobel, E12 / E24
+    ~CrossoverTarget() = default;
+};
+
+struct CrossoverResponse {
+    std::vector<double> spl;  // dB, 0 = enclosure passband driven directly
+    std::vector<double> phase;  // degrees
+    std::vector<double> impedance;  // ohms, seen by the amplifier
+    double min_impedance;  // ohms
+    double min_impedance_freq;  // Hz
+};
+
+struct CrossoverOptimization {
+    CrossoverDesign nominal;  // Exact values synthesized for a resistive Re load
+    CrossoverDesign design;  // Preferred values fitted to the driver's real load
+    double nominal_error;  // dB rms against the target
+    double error;
+    std::size_t evaluations;
+};
+
+// Passive network between the amplifier and a driver in its enclosure. The
+// driver impedance (Re, Le and the motional branch loaded by the box) and its
+// acoustic response are sampled once on a log grid; a candidate network then
+// costs one ladder walk per grid point.
+class Crossover {
+public:
+    Crossover(const TSParameters& params, const EnclosureResult& result, std::size_t points = 200, double f_min = 10.0,
+              double f_max = 20000.0);
+
+    bool ok() const { return !freqs_.empty(); }
+    const std::vector<double>& freqs() const { return freqs_; }
+    const std::vector<std::complex<double>>& driverImpedance() const { return driver_; }
+
+    // Textbook network by continued-fraction synthesis into a load of Re
+    CrossoverDesign design(const CrossoverTarget& target) const;
+    // Enclosure response times the ideal filter and level, dB per grid point
+    std::vector<double> targetCurve(const CrossoverTarget& target) const;
+    CrossoverResponse simulate(const CrossoverDesign& design) const;
+    // Snaps the synthesized design to preferred values, then walks single and
+    // paired E-series steps, every round's candidates scored across hardware threads
+    CrossoverOptimization optimize(const CrossoverTarget& target) const;
+
+private:
+    // Driver volts per input volt at grid point k
+    std::complex<double> transfer(const CrossoverDesign& design, std::size_t k, std::complex<double>* input_impedance) const;
+    double error(const CrossoverDesign& design, const std::vector<double>& target, double floor) const;
+
+    double re_;  // ohms
+    double le_;  // H
+    std::vector<double> freqs_;
+    std::vector<std::complex<double>> driver_;  // ohms
+    std::vector<std::complex<double>> acoustic_;  // Pressure per driver volt, passband 1
+};
+
+}  // namespace speakerbox
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "calculator.h"
+#include <cstddef>
+#include <vector>
+
+namespace speakerbox {
+
+struct Panel {
+    std::size_t cabinet;  // Index of the enclosure it belongs to
+    const char* name;
+    double width, height;  // mm
+};
+
+// Butt-jointed box: front and back cover the whole outside, the sides fit
+// between them, top and bottom between the sides. Each window brace is cut
+// as a full inside section and the window routed out afterwards.
+std::vector<Panel> cabinetPanels(const EnclosureResult& result, const CabinetConstraints& constraints, std::size_t cabinet);
+
+struct CutListOptions {
+    double sheet_width, sheet_height;  // mm
+    double kerf;  // mm, blade width
+    double trim;  // mm, trimmed off every sheet edge first
+    bool rotate;  // Panels may turn 90 degrees (no grain to follow)
+    std::size_t attempts;  // Packings tried, spread over hardware threads
+    std::size_t workers;  // Threads to spread them over; 0 for one per hardware thread
+
+    CutListOptions();  // 2440 x 1220 mm sheets, 3 mm kerf, 10 mm trim, rotation, 64 attempts, all threads
+    ~CutListOptions() = default;
+};
+
+struct Placement {
+    std::size_t panel;  // Index into the panel list
+    std::size_t sheet;
+    double x, y;  // mm from the sheet corner
+    bool rotated;
+};
+
+struct CutList {
+    std::vector<Placement> placements;  // Sheet by sheet
+    std::vector<std::size_t> unplaced;  // Panels larger than a trimmed sheet
+    std::size_t sheets;
+    double waste;  // Fraction of the sheets' area left over
+    double smallest_fill;  // Fraction of the emptiest sheet in use; the rest is one reusable offcut area
+};
+
+// Guillotine packing: every cut runs straight across the piece it divides, as
+// on a panel saw. An attempt takes the panels in one order and drops each into
+// the tightest free rectangle on any open sheet, splitting what is left with
+// one cut. Attempts differ in sort key, fit and split rule, and past the first
+// sixteen in seeded random jitter of the order; they run in parallel (on
+// CutListOptions::workers threads) and the fewest sheets win, then the emptiest
+// last sheet, then the lowest attempt, so the result does not depend on the
+// thread count.
+class CutListOptimizer {
+public:
+    explicit CutListOptimizer(const CutListOptions& options = CutListOptions());
+
+    CutList optimize(const std::vector<Panel>& panels) const;
+
+private:
+    CutList attempt(const std::vector<Panel>& panels, std::size_t index) const;
+
+    CutListOptions options_;
+};
+
+}  // namespace speakerbox
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "calculator.h"
+#include <cstddef>
+#include <vector>
+
+namespace speakerbox {
+
+struct PolarMap {
+    std::vector<double> freqs;  // Hz
+    std::vector<double> angles;  // degrees off axis in the horizontal plane, 0 to 180
+    std::vector<double> spl;  // dB, one row of angles per frequency; 0 dB = the cone alone in an infinite baffle
+    std::vector<double> di;  // dB per frequency
+
+    double at(std::size_t freq, std::size_t angle) const { return spl[freq * angles.size() + angle]; }
+};
+
+struct DirectivityMetrics {
+    double di_1k;  // dB
+    double di_10k;  // dB
+    double beaming_freq;  // Hz where 45 degrees first falls 6 dB below the axis; 0 if it never does
+    double on_axis_span;  // dB peak to peak on axis, 100 Hz - 5 kHz (baffle step and diffraction ripple)
+};
+
+// Far-field radiation of the driver, and of the vent, radiator or line mouth
+// where the enclosure has one, as rigid pistons (2 J1(ka sin t) / ka sin t)
+// on the front baffle at the box's outer size. Each source's baffle edges
+// act as kEdgePoints diffraction sources whose total strength is 1/2 less the
+// direct sound's weight. That weight fades smoothly from 1 to 0 across the
+// baffle plane, so the field stays continuous into the shadow behind the box
+// and low frequencies fall to half space. The vent volume
+// velocity follows the box tuning. Angles are the inner loops throughout, with
+// branch-free Bessel and sine kernels so the compiler vectorizes them.
+class DirectivityModel {
+public:
+    static constexpr std::size_t kEdgePoints = 32;  // Per source, at equal angles around it
+
+    // Needs 0 < f_min < f_max; otherwise the model is empty and computes nothing
+    DirectivityModel(std::size_t freq_points = 200, std::size_t angle_points = 180, double f_min = 20.0, double f_max = 20000.0);
+
+    bool ok() const { return !freqs_.empty(); }
+
+    const std::vector<double>& freqs() const { return freqs_; }
+    const std::vector<double>& angles() const { return angles_; }
+
+    // Empty spl when the design has no driver area or no box
+    PolarMap compute(const TSParameters& params, const EnclosureResult& result) const;
+    DirectivityMetrics metrics(const PolarMap& map) const;
+    // Metrics only, rows spread over hardware threads
+    std::vector<DirectivityMetrics> analyzeBatch(const std::vector<TSParameters>& params, const std::vector<EnclosureResult>& results) const;
+
+private:
+    struct Workspace {
+        std::vector<double> re, im;  // Pressure per angle
+        std::vector<double> edge_re, edge_im;
+        std::vector<double> piston;
+    };
+
+    Workspace makeWorkspace() const;
+    // spl is freqs x angles; false for a design with nothing to radiate
+    bool fill(const TSParameters& params, const EnclosureResult& result, Workspace& ws, double* spl, double* di) const;
+
+    std::vector<double> freqs_;
+    std::vector<double> angles_;
+    std::vector<double> sin_;  // Per angle
+    std::vector<double> rsqrt_sin_;  // 1 / sqrt(sin t), 0 on the axis
+    std::vector<double> direct_;  // Direct sound weight: 1 in front, 1/2 at 90 degrees, 0 behind, smooth between
+    std::vector<double> solid_;  // Trapezoid weights of sin t dt / 2 for the DI power average
+};
+
+}  // namespace speakerbox
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace speakerbox {
+
+// Forward-mode dual number: a value and its partial derivatives with respect
+// to N independent inputs, all carried through the arithmetic in one pass.
+// Comparisons look at the value only.
+template <std::size_t N>
+struct Dual {
+    double v;
+    std::array<double, N> d;
+
+    Dual() : v(0.0), d{} {}
+    Dual(double value) : v(value), d{} {}  // Constants have zero derivatives
+
+    static Dual variable(double value, std::size_t index) {
+        Dual x(value);
+        x.d[index] = 1.0;
+        return x;
+    }
+
+    Dual& operator+=(const Dual& o) {
+        v += o.v;
+        for (std::size_t i = 0; i < N; ++i) d[i] += o.d[i];
+        return *this;
+    }
+    Dual& operator-=(const Dual& o) {
+        v -= o.v;
+        for (std::size_t i = 0; i < N; ++i) d[i] -= o.d[i];
+        return *this;
+    }
+    Dual& operator*=(const Dual& o) {
+        for (std::size_t i = 0; i < N; ++i) d[i] = d[i] * o.v + v * o.d[i];
+        v *= o.v;
+        return *this;
+    }
+    Dual& operator/=(const Dual& o) {
+        double inv = 1.0 / o.v;
+        v *= inv;
+        for (std::size_t i = 0; i < N; ++i) d[i] = (d[i] - v * o.d[i]) * inv;
+        return *this;
+    }
+    Dual& operator*=(double k) {
+        v *= k;
+        for (std::size_t i = 0; i < N; ++i) d[i] *= k;
+        return *this;
+    }
+};
+
+// Value of a scalar of any supported type
+inline double primal(double x) { return x; }
+inline double primal(float x) { return x; }
+template <std::size_t N>
+double primal(const Dual<N>& x) { return x.v; }
+
+// f(x) given f(x0) and f'(x0) at x0 = primal(x): exact for the plain scalar
+// types, first order for duals, so table lookups keep their local slope
+inline double tangent(double value, double, double) { return value; }
+inline float tangent(double value, double, float) { return static_cast<float>(value); }
+template <std::size_t N>
+Dual<N> tangent(double value, double slope, const Dual<N>& x) {
+    Dual<N> r = x;
+    r *= slope;
+    r.v = value;
+    return r;
+}
+
+template <std::size_t N>
+Dual<N> operator-(Dual<N> a) {
+    a *= -1.0;
+    return a;
+}
+
+template <std::size_t N>
+Dual<N> operator+(Dual<N> a, const Dual<N>& b) { return a += b; }
+template <std::size_t N>
+Dual<N> operator+(Dual<N> a, double b) {
+    a.v += b;
+    return a;
+}
+template <std::size_t N>
+Dual<N> operator+(double a, Dual<N> b) {
+    b.v += a;
+    return b;
+}
+
+template <std::size_t N>
+Dual<N> operator-(Dual<N> a, const Dual<N>& b) { return a -= b; }
+template <std::size_t N>
+Dual<N> operator-(Dual<N> a, double b) {
+    a.v -= b;
+    return a;
+}
+template <std::size_t N>
+Dual<N> operator-(double a, const Dual<N>& b) { return Dual<N>(a) -= b; }
+
+template <std::size_t N>
+Dual<N> operator*(Dual<N> a, const Dual<N>& b) { return a *= b; }
+template <std::size_t N>
+Dual<N> operator*(Dual<N> a, double b) { return a *= b; }
+template <std::size_t N>
+Dual<N> operator*(double a, Dual<N> b) { return b *= a; }
+
+template <std::size_t N>
+Dual<N> operator/(Dual<N> a, const Dual<N>& b) { return a /= b; }
+template <std::size_t N>
+Dual<N> operator/(Dual<N> a, double b) { return a *= 1.0 / b; }
+template <std::size_t N>
+Dual<N> operator/(double a, const Dual<N>& b) { return Dual<N>(a) /= b; }
+
+template <std::size_t N>
+bool operator<(const Dual<N>& a, const Dual<N>& b) { return a.v < b.v; }
+template <std::size_t N>
+bool operator<(const Dual<N>& a, double b) { return a.v < b; }
+template <std::size_t N>
+bool operator<(double a, const Dual<N>& b) { return a < b.v; }
+template <std::size_t N>
+bool operator>(const Dual<N>& a, const Dual<N>& b) { return a.v > b.v; }
+template <std::size_t N>
+bool operator>(const Dual<N>& a, double b) { return a.v > b; }
+template <std::size_t N>
+bool operator>(double a, const Dual<N>& b) { return a > b.v; }
+template <std::size_t N>
+bool operator<=(const Dual<N>& a, double b) { return a.v <= b; }
+template <std::size_t N>
+bool operator>=(const Dual<N>& a, double b) { return a.v >= b; }
+
+template <std::size_t N>
+Dual<N> sqrt(const Dual<N>& x) {
+    double r = std::sqrt(x.v);
+    Dual<N> out = x;
+    out *= 0.5 / r;
+    out.v = r;
+    return out;
+}
+
+template <std::size_t N>
+Dual<N> pow(const Dual<N>& x, double p) {
+    double r = std::pow(x.v, p);
+    Dual<N> out = x;
+    out *= p * std::pow(x.v, p - 1.0);
+    out.v = r;
+    return out;
+}
+
+}  // namespace speakerbox
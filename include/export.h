@@ -0,0 +1,105 @@
+#pragma once
+
+#include "calculator.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace speakerbox {
+
+// Double-buffered file writer: the caller fills one block while a background
+// thread writes the other, so memory stays at two blocks
+class BlockWriter {
+public:
+    BlockWriter(const std::string& file, std::size_t block_size = 1 << 20, bool compress = false);
+    ~BlockWriter();
+
+    bool ok() const { return ok_; }
+    bool compressed() const { return compress_; }  // False when built without zlib
+
+    std::string& block() { return buffers_[active_]; }  // Append here, then call commit()
+    void write(const void* data, std::size_t size);
+    void commit();  // Hands the block off once it is full
+    void flush();  // Hands off whatever is buffered and waits for the disk
+    void close();
+
+private:
+    void run();
+    void swap();
+
+    std::FILE* file_;
+    void* gz_;
+    std::atomic<bool> ok_;
+    bool compress_;
+    std::size_t block_size_;
+    std::string buffers_[2];
+    int active_;
+    bool pending_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+enum class ExportFormat {
+    Csv,
+    JsonLines,
+    Columnar
+};
+
+// From the extension: .csv, .jsonl, .sbxc; a trailing .gz is ignored
+ExportFormat exportFormatFromPath(const std::string& file);
+
+// Streams EnclosureResult batches as CSV, JSON Lines or SBXC.
+//
+// SBXC is a little-endian columnar layout modelled on Arrow IPC record batches:
+//   header  "SBXC", u32 version (1), u32 column count,
+//           per column: u8 kind (0 f64, 1 u8, 2 utf8), u16 name length, name
+//   batch   u32 row count, then every column in header order:
+//           f64 -> rows x 8 bytes; u8 -> rows bytes;
+//           utf8 -> (rows + 1) u32 offsets, then the bytes
+//   footer  u32 0 (an empty batch)
+// type is a u8 holding the EnclosureType value (255 when unknown); warnings are joined with "; ".
+// With sensitivities, f64 columns d<output>_d<param> follow the result columns
+// (a "sensitivity" object of objects in JSON Lines).
+class ResultExporter {
+public:
+    static constexpr std::size_t kColumnarRows = 65536;  // Rows per SBXC batch
+
+    ResultExporter(const std::string& file, ExportFormat format, bool compress = false, bool sensitivities = false);
+    ~ResultExporter();
+
+    bool ok() const { return writer_.ok(); }
+    bool compressed() const { return writer_.compressed(); }
+    std::size_t rows() const { return rows_; }
+
+    // sensitivities, when the exporter has them, is parallel to batch
+    void write(const std::vector<EnclosureResult>& batch, const std::vector<Sensitivity>* sensitivities = nullptr);
+    void close();
+
+private:
+    void writeHeader();
+    void writeCsv(const EnclosureResult& result, const Sensitivity& sensitivity);
+    void writeJson(const EnclosureResult& result, const Sensitivity& sensitivity);
+    void appendColumnar(const EnclosureResult& result, const Sensitivity& sensitivity);
+    void flushColumnar();
+
+    BlockWriter writer_;
+    ExportFormat format_;
+    bool sensitivities_;
+    std::size_t rows_;
+    bool closed_;
+    // SBXC batch being assembled
+    std::vector<std::vector<double>> f64_columns_;
+    std::vector<unsigned char> type_column_, xmax_column_;
+    std::vector<std::uint32_t> warning_offsets_;
+    std::string warning_bytes_;
+};
+
+}  // namespace speakerbox
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace speakerbox {
+
+// Real FFT of even length n, computed as a mixed-radix (4, 2, 3, 5, then any
+// prime) Stockham transform of length n / 2. A plan is immutable once built,
+// so one instance can be shared by any number of threads as long as each
+// passes its own work buffer.
+class FftPlan {
+public:
+    explicit FftPlan(std::size_t n);  // Odd n is rounded up
+
+    // Shared plan for length n, built on first use
+    static std::shared_ptr<const FftPlan> get(std::size_t n);
+
+    std::size_t size() const { return n_; }
+    std::size_t bins() const { return n_ / 2 + 1; }
+    std::size_t workSize() const { return n_; }  // Complex values needed in work
+
+    // n real samples -> bins() complex values, unscaled
+    void forward(const double* in, std::complex<double>* out, std::complex<double>* work) const;
+    // bins() complex values -> n real samples, scaled by 1 / n
+    void inverse(const std::complex<double>* in, double* out, std::complex<double>* work) const;
+
+private:
+    struct Stage {
+        std::size_t radix;
+        std::size_t span;  // Length of each sub-transform entering the stage
+        std::size_t stride;  // Number of interleaved sub-transforms
+        std::size_t twiddle;  // Offset into twiddles_: (radix - 1) per butterfly
+        std::size_t roots;  // Offset into roots_, radix 5 and up
+    };
+
+    // Complex transform of length n / 2; returns the buffer holding the result
+    std::complex<double>* transform(std::complex<double>* x, std::complex<double>* y) const;
+
+    std::size_t n_;
+    std::vector<Stage> stages_;
+    std::vector<std::complex<double>> twiddles_;
+    std::vector<std::complex<double>> roots_;  // exp(-2 pi i j / radix)
+    std::vector<std::complex<double>> real_twiddles_;  // exp(-2 pi i k / n), k <= n / 2
+};
+
+}  // namespace speakerbox
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "calculator.h"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace speakerbox {
+
+enum class Parameter {
+    Fs,
+    Qts,
+    Vas,
+    Re,
+    Sd,
+    Xmax,
+    Vd,
+    Le,
+    Cms,
+    Mms,
+    Bl
+};
+
+// Derived quantities as nodes of a dependency graph; edits recompute only what they reach
+class DesignModel {
+public:
+    enum Node : unsigned {
+        Tuning = 1u << 0,  // alpha, vb, fc/fb, port length
+        Geometry = 1u << 1,  // port air velocity, excursion, dimensions
+        Transfer = 1u << 2,  // enclosure transfer function
+        Response = 1u << 3  // magnitude curve on the frequency grid
+    };
+
+    explicit DesignModel(Calculator& calc, const TSParameters& params = TSParameters());
+
+    void setParameter(Parameter param, double value);
+    void setType(EnclosureType type);
+    void setOption(const std::string& key, double value);
+    void setResponseGrid(double f_min, double f_max, std::size_t points);
+
+    // Recomputes dirty nodes in dependency order; returns the mask of nodes recomputed
+    unsigned update();
+
+    double parameter(Parameter param) const;
+    const TSParameters& params() const { return params_; }
+    EnclosureType type() const { return type_; }
+    const EnclosureResult& result() const { return result_; }
+    const TransferFunction& transfer() const { return transfer_; }
+    const std::vector<double>& frequencies() const { return freqs_; }
+    const std::vector<double>& response() const { return response_db_; }  // dB
+    double f3() const { return f3_; }  // Hz, -3 dB point below the passband
+
+    static std::string parameterName(Parameter param);
+    static double TSParameters::*member(Parameter param);
+
+private:
+    static unsigned dependents(Parameter param);
+    static unsigned dependents(const std::string& option);
+
+    void computeTuning();
+    void computeGeometry();
+    void computeTransfer();
+    void computeResponse();
+
+    Calculator& calc_;
+    TSParameters params_;
+    EnclosureType type_;
+    std::map<std::string, double> options_;
+    EnclosureResult result_;
+    std::vector<std::string> tuning_warnings_;  // Geometry adds its own on every pass
+    TransferFunction transfer_;
+    std::vector<double> freqs_;
+    std::vector<double> response_db_;
+    double f3_;
+    unsigned dirty_;
+};
+
+}  // namespace speakerbox
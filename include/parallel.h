@@ -0,0 +1,34 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace speakerbox {
+
+// Threads worth spreading count items over: one per hardware thread, or
+// threads when that is nonzero, but never so many that one gets fewer than
+// min_chunk. Always at least one.
+inline std::size_t parallelWorkers(std::size_t count, std::size_t min_chunk, std::size_t threads = 0) {
+    std::size_t workers = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    return std::min(workers, std::max<std::size_t>(1, count / std::max<std::size_t>(min_chunk, 1)));
+}
+
+// Calls fn(begin, end) on contiguous chunks of [0, count), one per worker as
+// parallelWorkers() picks them, and returns once all are done. The calling
+// thread takes the first chunk.
+template <typename Fn>
+void parallelFor(std::size_t count, std::size_t min_chunk, const Fn& fn, std::size_t threads = 0) {
+    if (count == 0) return;
+    const std::size_t workers = parallelWorkers(count, min_chunk, threads);
+    const std::size_t chunk = (count + workers - 1) / workers;
+    std::vector<std::thread> pool;
+    for (std::size_t begin = chunk; begin < count; begin += chunk) {
+        pool.emplace_back([&fn, begin, end = std::min(count, begin + chunk)]() { fn(begin, end); });
+    }
+    fn(0, std::min(count, chunk));
+    for (auto& t : pool) t.join();
+}
+
+}  // namespace speakerbox
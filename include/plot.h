@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace speakerbox {
+
+// Curves rasterized to Braille cells (2x4 dots each) over a log-frequency x axis.
+// render() emits only the cells that changed since the previous render.
+class BraillePlot {
+public:
+    static constexpr int kLabelWidth = 5;  // dB labels left of the plot area
+
+    BraillePlot(int cols, int rows, double f_min, double f_max, double db_min, double db_max);
+
+    int cols() const { return cols_; }
+    int rows() const { return rows_; }
+
+    void clear();
+    // color indexes the palette passed to render(); 0 is reserved for the grid
+    void plot(const std::vector<double>& freqs, const std::vector<double>& db, std::uint8_t color);
+    void invalidate();  // Next render redraws every cell
+
+    // Axis labels and grid; row/col are the 1-based terminal position of the top-left corner
+    std::string frame(int row, int col) const;
+    std::string render(int row, int col, const std::vector<std::string>& palette);
+
+private:
+    int pixelX(double freq) const;
+    int pixelY(double db) const;
+    void setDot(int px, int py, std::uint8_t color);
+    void line(int x0, int y0, int x1, int y1, std::uint8_t color);
+    void drawGrid();
+
+    int cols_, rows_;
+    double log_min_, log_scale_;
+    double db_min_, db_max_;
+    std::vector<std::uint8_t> dots_, colors_;  // Back buffer, one byte per cell
+    std::vector<std::uint8_t> front_dots_, front_colors_;  // What the terminal shows
+    std::vector<bool> dirty_rows_;
+};
+
+}  // namespace speakerbox
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "calculator.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace speakerbox {
+
+// y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]
+struct Biquad {
+    double b0, b1, b2, a1, a2;
+};
+
+// Bilinear transform of tf, prewarped so prewarp_freq (Hz) maps exactly,
+// factored into second-order sections (plus one first-order for odd orders)
+std::vector<Biquad> designBiquads(const TransferFunction& tf, double sample_rate, double prewarp_freq);
+
+// Cone displacement per volt (m/V) for the enclosure's small-signal model
+TransferFunction excursionTransfer(const TSParameters& params, const EnclosureResult& result);
+
+struct RenderOptions {
+    double drive;  // V rms into the driver for a full-scale sine
+    std::size_t block_frames;
+    bool check_excursion;
+
+    RenderOptions();
+    ~RenderOptions() = default;
+};
+
+struct RenderStats {
+    bool ok;
+    std::string error;
+    unsigned channels;
+    double sample_rate;
+    std::uint64_t frames;
+    std::uint64_t clipped;  // Output samples clamped to full scale
+    double peak_excursion;  // mm
+    std::vector<std::pair<double, double>> over_xmax;  // s, merged blocks past Xmax
+};
+
+// Streams a PCM / float WAV through the enclosure response. Memory is two
+// input and two output blocks whatever the file length: a reader thread fills
+// one block while the other is filtered, and BlockWriter drains the output.
+class Renderer {
+public:
+    static constexpr std::size_t kMaxSpans = 64;  // over_xmax entries kept
+
+    Renderer(const TSParameters& params, const EnclosureResult& result, const RenderOptions& options = RenderOptions());
+
+    bool ok() const { return !response_.den.empty(); }
+
+    RenderStats render(const std::string& input, const std::string& output) const;
+
+private:
+    TransferFunction response_;
+    TransferFunction excursion_;
+    double tuning_;  // Hz, prewarp point
+    double xmax_;  // m
+    RenderOptions options_;
+};
+
+}  // namespace speakerbox
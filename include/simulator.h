@@ -0,0 +1,78 @@
+#pragma once
+
+#include "calculator.h"
+#include <vector>
+
+namespace speakerbox {
+
+// Large-signal parameters as polynomials in u = x / Xmax, scaling the nominal
+// T/S value: Bl(x) = Bl * (c0 + c1 u + c2 u^2 + ...), likewise Cms(x) and Le(x)
+struct NonlinearParameters {
+    std::vector<double> bl;
+    std::vector<double> cms;
+    std::vector<double> le;
+    double thermal_resistance;  // K/W, voice coil to ambient at steady state; 0 disables heating
+
+    NonlinearParameters();  // Typical symmetric Bl/Cms drop, Le falling outward
+    ~NonlinearParameters() = default;
+};
+
+struct DistortionTest {
+    double frequency;  // Hz
+    double voltage;  // V rms
+    double frequency2;  // Hz, high tone of a 4:1 SMPTE pair; 0 for a single tone
+};
+
+struct DistortionResult {
+    double spl;  // dB SPL at 1 m (half space), fundamental or high tone
+    double thd;  // %
+    double h2, h3;  // %
+    double imd;  // %, two-tone only
+    double compression;  // dB lost against the small-signal level
+    double peak_excursion;  // mm
+};
+
+// Integrates the coupled electrical / mechanical / acoustic equations with
+// fixed-step RK4. Runs are packed kLanes to a batch (structure of arrays, so
+// the lane loops vectorize) and batches are spread over hardware threads.
+class Simulator {
+public:
+    static constexpr int kLanes = 8;
+    static constexpr int kMaxOrder = 6;  // Polynomial coefficients kept per parameter
+    static constexpr int kBins = 6;  // Spectral lines measured per run
+
+    Simulator(const TSParameters& params, const EnclosureResult& result, const NonlinearParameters& nonlinear = NonlinearParameters());
+
+    bool ok() const { return ok_; }
+    double sampleRate() const { return sample_rate_; }
+
+    std::vector<DistortionResult> run(const std::vector<DistortionTest>& tests) const;
+
+    static std::vector<DistortionTest> sweep(const std::vector<double>& freqs, const std::vector<double>& voltages);
+
+private:
+    struct Job {
+        double amp1, w1, amp2, w2;  // Peak volts, rad/s
+        double re;  // Hot voice-coil resistance
+        double bins[kBins];  // Hz
+        long settle, window;  // Samples
+    };
+    struct Measurement {
+        double mag[kBins];  // Volume velocity amplitude, m^3/s
+        double peak_x;  // m
+    };
+
+    void runBatch(const Job* jobs, int count, Measurement* out) const;
+    Job makeJob(const DistortionTest& test, double scale) const;
+
+    bool ok_;
+    double sample_rate_;
+    double re_, le_, bl_, mms_, cms_, rms_, sd_, xmax_;  // SI units
+    double thermal_resistance_;
+    double k_box_;  // Pa per m^3 of displaced volume
+    double map_, rap_;  // Vent acoustic mass and loss; map_ = 0 for a sealed box
+    bool radiate_cone_;  // Bandpass radiates through the vent only
+    double bl_poly_[kMaxOrder], cms_poly_[kMaxOrder], le_poly_[kMaxOrder];
+};
+
+}  // namespace speakerbox
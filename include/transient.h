@@ -0,0 +1,59 @@
+#pragma once
+
+#include "calculator.h"
+#include "fft.h"
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace speakerbox {
+
+struct TransientMetrics {
+    double group_delay_at_tuning;  // ms at Fc / Fb
+    double peak_group_delay;  // ms
+    double peak_group_delay_freq;  // Hz
+    double step_undershoot;  // % of the step peak
+    double decay_time;  // ms until the step stays within -40 dB of its peak
+};
+
+struct TransientResult {
+    TransientMetrics metrics;
+    std::vector<double> impulse;  // Per sample, unit passband gain
+    std::vector<double> step;
+    std::vector<double> freqs;  // Hz, group delay grid
+    std::vector<double> group_delay;  // ms
+};
+
+// Time-domain view of an enclosure transfer function: the response is sampled
+// on the FFT grid, band-limited with a raised-cosine roll-off over the top
+// half-octave, and inverted to an impulse. Group delay comes from the
+// Hann-windowed impulse as Re{FFT(t h[t]) / FFT(h[t])}.
+class TransientAnalyzer {
+public:
+    TransientAnalyzer(double sample_rate = 4096.0, std::size_t length = 8192, double max_freq = 500.0);
+
+    double sampleRate() const { return sample_rate_; }
+    std::size_t length() const { return plan_->size(); }
+
+    TransientResult analyze(const TransferFunction& tf, double tuning) const;
+    // Metrics only; the FFT plan is shared read-only and every thread has its own buffers
+    std::vector<TransientMetrics> analyzeBatch(const Calculator& calc, const std::vector<TSParameters>& params,
+                                               const std::vector<EnclosureResult>& results) const;
+
+private:
+    struct Workspace {
+        std::vector<std::complex<double>> spectrum, weighted, work;
+        std::vector<double> impulse, ramp, step;  // step holds the causal half only
+    };
+
+    Workspace makeWorkspace() const;
+    TransientMetrics measure(const TransferFunction& tf, double tuning, Workspace& ws, TransientResult* curves) const;
+
+    double sample_rate_;
+    double max_freq_;
+    std::shared_ptr<const FftPlan> plan_;
+    std::vector<double> taper_;  // Per bin
+    std::vector<double> window_;  // Per sample
+};
+
+}  // namespace speakerbox
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "model.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -11,28 +12,38 @@ namespace speakerbox {
 
 class UI {
 public:
+    static constexpr char kEndOfInput = '\004';  // getKey() once stdin is closed
+
     UI(bool use_color = true);
     ~UI();
 
     void showSplash() const;
     void clearScreen() const;
     void drawBox(const std::string& title, const std::vector<std::string>& content) const;
-    int showMenu(const std::string& title, const std::vector<std::string>& options) const;
+    int showMenu(const std::string& title, const std::vector<std::string>& options) const;  // -1 at end of input
     std::string getInput(const std::string& prompt, bool password = false) const;
     void showProgress(int duration_ms) const;
     void displayResult(const EnclosureResult& result) const;
+    // Result plus a sensitivity report: % change per % change of each parameter
+    void displayResult(const EnclosureResult& result, const TSParameters& params, const Sensitivity& sensitivity) const;
+    void liveEdit(DesignModel& model) const;
     void showHelp() const;
     void showWarning(const std::string& msg) const;
     void showError(const std::string& msg) const;
     bool checkTerminalSize() const;
+    void setColor(bool use_color) { use_color_ = use_color; }
 
 private:
     bool use_color_;
     std::map<std::string, std::string> colors_;
-    std::mutex mutex_;
+    mutable std::mutex mutex_;
 
     std::string color(const std::string& code) const;
+    std::vector<std::string> resultLines(const EnclosureResult& result) const;
+    std::vector<std::string> sensitivityLines(const EnclosureResult& result, const TSParameters& params, const Sensitivity& sensitivity) const;
+    std::vector<std::string> palette() const;
     char getKey() const;  // For arrow input
+    bool terminalSize(int& rows, int& cols) const;  // Leaves both alone when stdin is not a terminal
 };
 
 }  // namespace speakerbox
@@ -0,0 +1,84 @@
+#include "alignment.h"
+#include <cmath>
+
+namespace speakerbox {
+
+namespace alignment {
+
+namespace {
+
+constexpr Tables kTables = makeTables();
+
+// Classic lossless B4: Qt = 0.383, h = 1, alpha = sqrt(2)
+static_assert(kTables[2][0].points[0].qt > 0.3826 && kTables[2][0].points[0].qt < 0.3828, "B4 Qt");
+static_assert(kTables[2][0].points[0].h > 0.9999 && kTables[2][0].points[0].h < 1.0001, "B4 h");
+static_assert(kTables[2][0].points[0].alpha > 1.4141 && kTables[2][0].points[0].alpha < 1.4143, "B4 alpha");
+
+AlignmentPoint interpolate(const Table& t, double qts, bool& in_range, AlignmentPoint& slope) {
+    slope = {1.0, 0.0, 0.0};
+    if (t.qt_step <= 0.0) {
+        in_range = std::abs(qts - t.qt_min) < 0.01;
+        return t.points[0];
+    }
+    double x = (qts - t.qt_min) / t.qt_step;
+    if (x < 0.0 || x > kTableSize - 1) in_range = false;
+    if (x < 0.0) x = 0.0;
+    if (x > kTableSize - 1) x = kTableSize - 1;
+    std::size_t i = static_cast<std::size_t>(x);
+    if (i >= kTableSize - 1) i = kTableSize - 2;
+    double f = x - i;
+    const AlignmentPoint& a = t.points[i];
+    const AlignmentPoint& b = t.points[i + 1];
+    if (in_range) slope = {1.0, (b.h - a.h) / t.qt_step, (b.alpha - a.alpha) / t.qt_step};
+    return {qts, a.h + f * (b.h - a.h), a.alpha + f * (b.alpha - a.alpha)};
+}
+
+}  // namespace
+
+const Table& table(Alignment family, std::size_t ql_index) {
+    return kTables[static_cast<std::size_t>(family)][ql_index];
+}
+
+}  // namespace alignment
+
+AlignmentPoint lookupAlignment(Alignment family, double qts, double ql, bool* in_range, AlignmentPoint* slope) {
+    using namespace alignment;
+    double inv_ql = ql > 0.0 ? 1.0 / ql : 0.0;
+    if (inv_ql > kInvQL.back()) inv_ql = kInvQL.back();
+    std::size_t q = 0;
+    while (q + 2 < kInvQL.size() && kInvQL[q + 1] < inv_ql) ++q;
+    double f = (inv_ql - kInvQL[q]) / (kInvQL[q + 1] - kInvQL[q]);
+
+    bool ok_a = true, ok_b = true;
+    AlignmentPoint da, db;
+    AlignmentPoint a = interpolate(table(family, q), qts, ok_a, da);
+    AlignmentPoint b = interpolate(table(family, q + 1), qts, ok_b, db);
+    if (in_range) *in_range = (f >= 1.0 || ok_a) && (f <= 0.0 || ok_b);
+    if (slope) *slope = {1.0, da.h + f * (db.h - da.h), da.alpha + f * (db.alpha - da.alpha)};
+    return {qts, a.h + f * (b.h - a.h), a.alpha + f * (b.alpha - a.alpha)};
+}
+
+Alignment recommendAlignment(double qts, double ql) {
+    using namespace alignment;
+    double inv_ql = ql > 0.0 ? 1.0 / ql : 0.0;
+    if (inv_ql > kInvQL.back()) inv_ql = kInvQL.back();
+    std::size_t q = 0;
+    while (q + 2 < kInvQL.size() && kInvQL[q + 1] < inv_ql) ++q;
+    double f = (inv_ql - kInvQL[q]) / (kInvQL[q + 1] - kInvQL[q]);
+    double a = table(Alignment::B4, q).qt_min;
+    double b4_qt = a + f * (table(Alignment::B4, q + 1).qt_min - a);
+    return qts < b4_qt ? Alignment::QB3 : Alignment::C4;
+}
+
+std::string alignmentName(Alignment family) {
+    switch (family) {
+        case Alignment::QB3: return "QB3";
+        case Alignment::SBB4: return "SBB4";
+        case Alignment::B4: return "B4";
+        case Alignment::C4: return "C4";
+        case Alignment::BB4: return "BB4";
+    }
+    return "Unknown";
+}
+
+}  // namespace speakerbox
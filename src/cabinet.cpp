@@ -0,0 +1,159 @@
+#include "cabinet.h"
+#include "calculator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace speakerbox {
+
+constexpr double GOLDEN_RATIO_H = 1.6;
+constexpr double GOLDEN_RATIO_W = 1.0;
+constexpr double GOLDEN_RATIO_D = 0.6;
+
+CabinetConstraints::CabinetConstraints()
+    : panel(18.0), braces(1), brace_width(50.0), cutout(0.0), max_width(0.0), max_height(0.0), max_depth(0.0),
+      ratio_width(GOLDEN_RATIO_W), ratio_height(GOLDEN_RATIO_H), ratio_depth(GOLDEN_RATIO_D) {}
+
+const std::vector<std::string>& CabinetConstraints::optionKeys() {
+    static const std::vector<std::string> keys = {"panel", "braces", "brace_width", "cutout", "max_width", "max_height", "max_depth"};
+    return keys;
+}
+
+CabinetConstraints CabinetConstraints::fromOptions(const std::map<std::string, double>& options) {
+    CabinetConstraints c;
+    auto read = [&](const char* key, double& field) {
+        auto it = options.find(key);
+        if (it != options.end()) field = it->second;
+    };
+    double braces = c.braces;
+    read("panel", c.panel);
+    read("braces", braces);
+    read("brace_width", c.brace_width);
+    read("cutout", c.cutout);
+    read("max_width", c.max_width);
+    read("max_height", c.max_height);
+    read("max_depth", c.max_depth);
+    c.braces = std::max(static_cast<int>(braces), 0);
+    return c;
+}
+
+namespace {
+
+// Volume a window brace takes out of the width x depth section, cm^3 per cm of thickness
+template <typename T>
+T braceArea(const T& w, const T& d, double rail) {
+    T area = w * d;
+    if (w > 2.0 * rail && d > 2.0 * rail) area = area - (w - 2.0 * rail) * (d - 2.0 * rail);
+    return area;
+}
+
+template <typename T>
+T airVolume(const T& w, const T& h, const T& d, const CabinetConstraints& c) {
+    return w * h * d - braceArea(w, d, c.brace_width / 10.0) * (c.braces * c.panel / 10.0);
+}
+
+// d(air) / d(width) and d(air) / d(depth) through the brace window
+double braceSlope(double along, double across, double rail) {
+    return along > 2.0 * rail && across > 2.0 * rail ? 2.0 * rail : across;
+}
+
+}  // namespace
+
+template <typename T>
+BasicCabinet<T> solveCabinet(T net_volume, T displaced, T cutout, const CabinetConstraints& constraints) {
+    BasicCabinet<T> cabinet{};
+    cabinet.fits = true;
+    cabinet.baffle_fits = true;
+    const double t = constraints.panel / 10.0;  // cm
+    const double rail = constraints.brace_width / 10.0;
+    const double braces = constraints.braces * t;
+    const double ratio[3] = {constraints.ratio_width, constraints.ratio_height, constraints.ratio_depth};
+    const double limit[3] = {constraints.max_width, constraints.max_height, constraints.max_depth};
+    T gross = net_volume + displaced;
+    const double target = primal(gross) * 1000.0;  // cm^3
+    if (!(target > 0.0) || ratio[0] <= 0.0 || ratio[1] <= 0.0 || ratio[2] <= 0.0) return cabinet;
+
+    double lo[3] = {primal(cutout), primal(cutout), 0.0};
+    double hi[3];
+    bool held_by_cutout[3];
+    for (int i = 0; i < 3; ++i) {
+        hi[i] = limit[i] > 0.0 ? std::max(limit[i] - 2.0 * t, 0.0) : HUGE_VAL;
+        held_by_cutout[i] = i < 2 && lo[i] > 0.0 && lo[i] <= hi[i];
+        if (lo[i] > hi[i]) {
+            lo[i] = hi[i];
+            cabinet.baffle_fits = false;  // The baffle cannot take the driver; the volume is still solved for
+        }
+        if (hi[i] <= 0.0) {
+            cabinet.fits = false;  // Panels alone fill the limit: no box at all
+            return cabinet;
+        }
+    }
+    auto size = [&](double s, double* dims) {
+        for (int i = 0; i < 3; ++i) dims[i] = std::clamp(s * ratio[i], lo[i], hi[i]);
+    };
+    auto air = [&](double s) {
+        double dims[3];
+        size(s, dims);
+        return airVolume(dims[0], dims[1], dims[2], constraints);
+    };
+
+    // Bracket the scale, then bisect: air volume only grows with it. Once every
+    // side is at its maximum nothing is left to solve for; a scale that would
+    // overflow means the same.
+    double s_lo = 0.0, s_hi = std::cbrt(target / (ratio[0] * ratio[1] * ratio[2]));
+    while (!(air(s_hi) >= target)) {
+        bool at_max = s_hi * ratio[0] >= hi[0] && s_hi * ratio[1] >= hi[1] && s_hi * ratio[2] >= hi[2];
+        if (at_max || !std::isfinite(2.0 * s_hi)) {
+            cabinet.fits = false;
+            break;
+        }
+        s_lo = s_hi;
+        s_hi *= 2.0;
+    }
+    if (cabinet.fits) {
+        for (int it = 0; it < 100 && s_hi - s_lo > 1e-13 * s_hi; ++it) {
+            double mid = 0.5 * (s_lo + s_hi);
+            if (air(mid) < target) {
+                s_lo = mid;
+            } else {
+                s_hi = mid;
+            }
+        }
+    }
+    const double s = s_hi;
+    double dims[3];
+    size(s, dims);
+
+    // Sides still on the scale move with it; the rest sit at a bound
+    bool free[3];
+    for (int i = 0; i < 3; ++i) free[i] = s * ratio[i] > lo[i] && s * ratio[i] < hi[i];
+    double partial[3] = {dims[1] * dims[2] - braces * braceSlope(dims[0], dims[2], rail), dims[0] * dims[2],
+                         dims[0] * dims[1] - braces * braceSlope(dims[2], dims[0], rail)};
+    double slope = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        if (free[i]) slope += ratio[i] * partial[i];
+    }
+    auto side = [&](int i, const T& scale) -> T {
+        if (free[i]) return scale * ratio[i];
+        if (held_by_cutout[i] && dims[i] == lo[i]) return cutout;
+        return T(dims[i]);
+    };
+    T scale = T(s);
+    if (cabinet.fits && slope > 0.0) {
+        T residual = airVolume(side(0, scale), side(1, scale), side(2, scale), constraints) - gross * 1000.0;
+        scale = scale - residual / slope;
+    }
+    cabinet.width = side(0, scale);
+    cabinet.height = side(1, scale);
+    cabinet.depth = side(2, scale);
+    cabinet.outer_width = cabinet.width + 2.0 * t;
+    cabinet.outer_height = cabinet.height + 2.0 * t;
+    cabinet.outer_depth = cabinet.depth + 2.0 * t;
+    cabinet.bracing = braceArea(cabinet.width, cabinet.depth, rail) * braces / 1000.0;
+    return cabinet;
+}
+
+template BasicCabinet<double> solveCabinet<double>(double, double, double, const CabinetConstraints&);
+template BasicCabinet<float> solveCabinet<float>(float, float, float, const CabinetConstraints&);
+template BasicCabinet<Gradient> solveCabinet<Gradient>(Gradient, Gradient, Gradient, const CabinetConstraints&);
+
+}  // namespace speakerbox
@@ -1,13 +1,34 @@
 #include "calculator.h"
+#include "constants.h"
+#include "parallel.h"
+#include <algorithm>
 
 namespace speakerbox {
 
-constexpr double SPEED_SOUND = 343.0;  // m/s
-constexpr double GOLDEN_RATIO_H = 1.6;
-constexpr double GOLDEN_RATIO_W = 1.0;
-constexpr double GOLDEN_RATIO_D = 0.6;
+constexpr double CUTOUT_PER_PISTON = 1.1;  // Cutout diameter over the effective cone diameter
 
-TSParameters::TSParameters() : fs(0.0), qts(0.0), vas(0.0), re(0.0), sd(0.0), xmax(0.0), vd(0.0), le(0.0), cms(0.0), mms(0.0), bl(0.0) {}
+TSParameters completeParameters(const TSParameters& params) {
+    TSParameters full = params;
+    double sd = params.sd * 1e-4;  // m^2
+    double ws = 2.0 * PI * params.fs;
+    if (full.cms <= 0.0 && sd > 0.0) full.cms = params.vas * 1e-3 / (AIR_DENSITY * SPEED_SOUND * SPEED_SOUND * sd * sd);
+    if (full.mms <= 0.0 && full.cms > 0.0 && ws > 0.0) full.mms = 1e3 / (ws * ws * full.cms);
+    if (full.bl <= 0.0 && params.qts > 0.0 && params.re > 0.0) {
+        const double qms = 5.0;
+        double qes = 1.0 / (1.0 / params.qts - 1.0 / qms);
+        full.bl = std::sqrt(ws * full.mms * 1e-3 * params.re / qes);
+    }
+    return full;
+}
+
+double mechanicalResistance(const TSParameters& full) {
+    const double ws = 2.0 * PI * full.fs;
+    const double mms = full.mms * 1e-3;  // kg
+    double qms = 5.0;
+    double inv_qms = 1.0 / full.qts - full.bl * full.bl / (ws * mms * full.re);
+    if (inv_qms > 0.0) qms = 1.0 / inv_qms;
+    return ws * mms / qms;
+}
 
 Calculator::Calculator() = default;
 
@@ -19,94 +40,195 @@ std::string Calculator::recommendType(double qts) const {
     return "Other";
 }
 
-EnclosureResult Calculator::calculate(const TSParameters& params, EnclosureType type, const std::map<std::string, double>& options) {
-    EnclosureResult result;
-    result.within_xmax = checkExcursion(params.xmax);
+template <typename T>
+BasicEnclosureResult<T> Calculator::calculate(const BasicTSParameters<T>& params, EnclosureType type, const std::map<std::string, double>& options) {
+    BasicEnclosureResult<T> result = calculateTuning(params, type, options);
+    calculateGeometry(result, params, options);
+    return result;
+}
+
+template <typename T>
+BasicEnclosureResult<T> Calculator::calculateTuning(const BasicTSParameters<T>& params, EnclosureType type, const std::map<std::string, double>& options) {
+    BasicEnclosureResult<T> result{};
     result.type = "Unknown";
 
     double desired_qtc = options.count("qtc") ? options.at("qtc") : 0.707;
-    double desired_fb = options.count("fb") ? options.at("fb") : params.fs;
+    double ql = options.count("ql") ? options.at("ql") : 7.0;
+    Alignment alignment = recommendAlignment(primal(params.qts), ql);
+    bool bad_alignment = false;
+    if (options.count("alignment")) {
+        double family = options.at("alignment");
+        if (family >= 0.0 && family < alignment::kFamilies && family == std::floor(family)) {
+            alignment = static_cast<Alignment>(static_cast<int>(family));
+        } else {
+            bad_alignment = true;
+        }
+    }
     double s = options.count("s") ? options.at("s") : 0.6;
     double tr = options.count("tr") ? options.at("tr") : 1.0;
     double delta = options.count("delta") ? options.at("delta") : 1.0;
 
     switch (type) {
         case EnclosureType::Sealed:
-            return calculateSealed(params, desired_qtc);
+            result = calculateSealed(params, desired_qtc);
+            break;
         case EnclosureType::Ported:
-            return calculatePorted(params, desired_fb);
+            result = calculatePorted(params, alignment, ql);
+            break;
         case EnclosureType::Bandpass:
-            return calculateBandpass(params, s);
+            result = calculateBandpass(params, s);
+            break;
         case EnclosureType::TransmissionLine:
-            return calculateTransmissionLine(params, tr);
+            result = calculateTransmissionLine(params, tr);
+            break;
         case EnclosureType::PassiveRadiator:
-            return calculatePassiveRadiator(params, delta);
+            result = calculatePassiveRadiator(params, delta);
+            break;
+        default:
+            result.warnings.push_back("Invalid type");
+            break;
     }
-    result.warnings.push_back("Invalid type");
+    if (bad_alignment) result.warnings.push_back("Unknown alignment, using " + alignmentName(alignment));
+    return result;
+}
+
+template <typename T>
+void Calculator::calculateGeometry(BasicEnclosureResult<T>& result, const BasicTSParameters<T>& params, const std::map<std::string, double>& options) {
+    if (result.port_diameter > 0.0) result.air_velocity = calculatePortAirVelocity(params.sd, params.xmax, result.fc_or_fb);
+    if (result.vb > 0.0) sizeCabinet(result, params, CabinetConstraints::fromOptions(options));
+    result.within_xmax = checkExcursion(params.xmax);
+}
+
+EnclosureResult Calculator::calculateSensitivity(const TSParameters& params, EnclosureType type, Sensitivity& sensitivity,
+                                                 const std::map<std::string, double>& options) {
+    // Seed each field as its own independent variable
+    BasicTSParameters<Gradient> seeded;
+    Gradient BasicTSParameters<Gradient>::*fields[kParameterCount] = {
+        &BasicTSParameters<Gradient>::fs, &BasicTSParameters<Gradient>::qts, &BasicTSParameters<Gradient>::vas,
+        &BasicTSParameters<Gradient>::re, &BasicTSParameters<Gradient>::sd, &BasicTSParameters<Gradient>::xmax,
+        &BasicTSParameters<Gradient>::vd, &BasicTSParameters<Gradient>::le, &BasicTSParameters<Gradient>::cms,
+        &BasicTSParameters<Gradient>::mms, &BasicTSParameters<Gradient>::bl};
+    const double TSParameters::*values[kParameterCount] = {
+        &TSParameters::fs, &TSParameters::qts, &TSParameters::vas, &TSParameters::re, &TSParameters::sd, &TSParameters::xmax,
+        &TSParameters::vd, &TSParameters::le, &TSParameters::cms, &TSParameters::mms, &TSParameters::bl};
+    for (std::size_t i = 0; i < kParameterCount; ++i) seeded.*fields[i] = Gradient::variable(params.*values[i], i);
+
+    BasicEnclosureResult<Gradient> dual = calculate(seeded, type, options);
+    EnclosureResult result{};
+    result.type = dual.type;
+    result.vb = dual.vb.v;
+    result.fc_or_fb = dual.fc_or_fb.v;
+    result.freq_response = dual.freq_response;
+    result.port_length = dual.port_length.v;
+    result.port_diameter = dual.port_diameter.v;
+    result.air_velocity = dual.air_velocity.v;
+    result.alpha = dual.alpha.v;
+    result.ql = dual.ql.v;
+    result.width = dual.width.v;
+    result.height = dual.height.v;
+    result.depth = dual.depth.v;
+    result.outer_width = dual.outer_width.v;
+    result.outer_height = dual.outer_height.v;
+    result.outer_depth = dual.outer_depth.v;
+    result.displacement = dual.displacement.v;
+    result.within_xmax = dual.within_xmax;
+    result.warnings = dual.warnings;
+    sensitivity.vb = dual.vb.d;
+    sensitivity.fc_or_fb = dual.fc_or_fb.d;
+    sensitivity.port_length = dual.port_length.d;
+    sensitivity.width = dual.width.d;
+    sensitivity.height = dual.height.d;
+    sensitivity.depth = dual.depth.d;
     return result;
 }
 
-EnclosureResult Calculator::calculateSealed(const TSParameters& params, double desired_qtc) {
-    EnclosureResult result;
+std::vector<EnclosureResult> Calculator::calculateBatch(const std::vector<TSParameters>& params, EnclosureType type, const std::map<std::string, double>& options,
+                                                        std::vector<Sensitivity>* sensitivities) {
+    std::vector<EnclosureResult> results(params.size());
+    if (sensitivities) sensitivities->resize(params.size());
+    parallelFor(params.size(), 1024, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (sensitivities) results[i] = calculateSensitivity(params[i], type, (*sensitivities)[i], options);
+            else results[i] = calculate(params[i], type, options);
+        }
+    });
+    return results;
+}
+
+template <typename T>
+BasicEnclosureResult<T> Calculator::calculateSealed(const BasicTSParameters<T>& params, double desired_qtc) {
+    using std::pow;
+    using std::sqrt;
+    BasicEnclosureResult<T> result{};
     result.type = "Sealed";
-    double alpha = std::pow(desired_qtc / params.qts, 2) - 1.0;
+    T alpha = pow(desired_qtc / params.qts, 2.0) - 1.0;
     if (alpha <= 0.0) {
         result.warnings.push_back("Invalid alpha");
         return result;
     }
+    result.alpha = alpha;
+    result.ql = 0.0;
     result.vb = params.vas / alpha;
-    result.fc_or_fb = params.fs * std::sqrt(1.0 + alpha);
+    result.fc_or_fb = params.fs * sqrt(1.0 + alpha);
     result.freq_response = "12 dB/octave roll-off below Fc";
     result.port_length = 0.0;
     result.port_diameter = 0.0;
     result.air_velocity = 0.0;
-    result.vb = subtractDisplacements(result.vb, params);
-    applyGoldenRatio(result.vb, result.width, result.height, result.depth);
     return result;
 }
 
-EnclosureResult Calculator::calculatePorted(const TSParameters& params, double desired_fb) {
-    EnclosureResult result;
+template <typename T>
+BasicEnclosureResult<T> Calculator::calculatePorted(const BasicTSParameters<T>& params, Alignment alignment, double ql) {
+    BasicEnclosureResult<T> result{};
     result.type = "Ported";
-    // Approximate Butterworth B4
-    double h = desired_fb / params.fs;
-    double alpha = (1.0 / (h * h)) - 1.0;
+    bool in_range = true;
+    AlignmentPoint slope;
+    AlignmentPoint point = lookupAlignment(alignment, primal(params.qts), ql, &in_range, &slope);
+    if (!in_range) result.warnings.push_back("Qts outside " + alignmentName(alignment) + " range");
+    if (point.alpha <= 0.0) {
+        result.warnings.push_back("Invalid alpha");
+        return result;
+    }
+    T h = tangent(point.h, slope.h, params.qts);
+    T alpha = tangent(point.alpha, slope.alpha, params.qts);
+    T desired_fb = h * params.fs;
+    result.alpha = alpha;
+    result.ql = ql;
     result.vb = params.vas / alpha;
     result.fc_or_fb = desired_fb;
-    result.freq_response = "24 dB/octave roll-off below Fb";
+    result.freq_response = "24 dB/octave roll-off below Fb (" + alignmentName(alignment) + ")";
     result.port_diameter = 5.0;  // Default cm
-    double r = result.port_diameter / 2.0;
+    T r = result.port_diameter / 2.0;
     result.port_length = (23562.5 * r * r) / (desired_fb * desired_fb * result.vb) - 0.85 * result.port_diameter;  // Approx cm
-    result.air_velocity = calculatePortAirVelocity(params.sd, params.xmax, desired_fb);
-    double port_vol = PI * r * r * result.port_length / 1000.0;  // liters
-    result.vb = subtractDisplacements(result.vb, params, port_vol);
-    applyGoldenRatio(result.vb, result.width, result.height, result.depth);
     return result;
 }
 
-EnclosureResult Calculator::calculateBandpass(const TSParameters& params, double s) {
-    EnclosureResult result;
+template <typename T>
+BasicEnclosureResult<T> Calculator::calculateBandpass(const BasicTSParameters<T>& params, double s) {
+    using std::pow;
+    BasicEnclosureResult<T> result{};
     result.type = "Bandpass";
     double qbp = 1.0 / (2.0 * s);  // Approx from alignments
-    double vf = std::pow(2.0 * s * params.qts, 2) * params.vas;
-    double vr = params.vas / (std::pow(qbp / params.qts, 2) - 1.0);
+    T vf = pow(2.0 * s * params.qts, 2.0) * params.vas;
+    T vr = params.vas / (pow(qbp / params.qts, 2.0) - 1.0);
     result.vb = vf + vr;
+    result.alpha = params.vas / result.vb;
+    result.ql = 0.0;
     result.fc_or_fb = qbp * (params.fs / params.qts);
     result.freq_response = "Bandpass response";
     result.port_diameter = 5.0;
-    double r = result.port_diameter / 2.0;
+    T r = result.port_diameter / 2.0;
     result.port_length = (94250.0 * r * r) / (result.fc_or_fb * result.fc_or_fb * vf) - 1.595 * r;
-    result.air_velocity = calculatePortAirVelocity(params.sd, params.xmax, result.fc_or_fb);
-    double port_vol = PI * r * r * result.port_length / 1000.0;
-    result.vb = subtractDisplacements(result.vb, params, port_vol);
-    applyGoldenRatio(result.vb, result.width, result.height, result.depth);
     return result;
 }
 
-EnclosureResult Calculator::calculateTransmissionLine(const TSParameters& params, double tr) {
-    EnclosureResult result;
+template <typename T>
+BasicEnclosureResult<T> Calculator::calculateTransmissionLine(const BasicTSParameters<T>& params, double tr) {
+    BasicEnclosureResult<T> result{};
     result.type = "TransmissionLine";
     double alpha = 1.5198;  // From table example
+    result.alpha = alpha;
+    result.ql = 0.0;
     result.vb = params.vas / alpha;
     double h = 1.0;  // From table
     result.fc_or_fb = h * params.fs;
@@ -116,15 +238,16 @@ EnclosureResult Calculator::calculateTransmissionLine(const TSParameters& params
     result.port_length = sf * (SPEED_SOUND) / (4.0 * result.fc_or_fb) * 100.0;  // cm
     result.port_diameter = 0.0;
     result.air_velocity = 0.0;
-    result.vb = subtractDisplacements(result.vb, params);
-    applyGoldenRatio(result.vb, result.width, result.height, result.depth);
     return result;
 }
 
-EnclosureResult Calculator::calculatePassiveRadiator(const TSParameters& params, double delta) {
-    EnclosureResult result;
+template <typename T>
+BasicEnclosureResult<T> Calculator::calculatePassiveRadiator(const BasicTSParameters<T>& params, double delta) {
+    BasicEnclosureResult<T> result{};
     result.type = "PassiveRadiator";
     double alpha = delta;  // Assume
+    result.alpha = alpha;
+    result.ql = 0.0;
     result.vb = params.vas / alpha;
     double h = 1.51;  // From example
     result.fc_or_fb = h * params.fs;
@@ -132,32 +255,80 @@ EnclosureResult Calculator::calculatePassiveRadiator(const TSParameters& params,
     result.port_length = 0.0;
     result.port_diameter = 0.0;
     result.air_velocity = 0.0;
-    result.vb = subtractDisplacements(result.vb, params);
-    applyGoldenRatio(result.vb, result.width, result.height, result.depth);
     return result;
 }
 
-void Calculator::applyGoldenRatio(double vb, double& width, double& height, double& depth) const {
-    double cube_root = std::pow(vb * 1000.0, 1.0 / 3.0);  // cm
-    width = cube_root * GOLDEN_RATIO_W;
-    height = cube_root * GOLDEN_RATIO_H;
-    depth = cube_root * GOLDEN_RATIO_D;
+std::complex<double> TransferFunction::evaluate(double freq) const {
+    std::complex<double> s(0.0, 2.0 * PI * freq);
+    std::complex<double> n = 0.0, d = 0.0;
+    for (auto it = num.rbegin(); it != num.rend(); ++it) n = n * s + *it;
+    for (auto it = den.rbegin(); it != den.rend(); ++it) d = d * s + *it;
+    return n / d;
 }
 
-double Calculator::calculatePortAirVelocity(double sd, double xmax, double fb) const {
+TransferFunction Calculator::transferFunction(const TSParameters& params, const EnclosureResult& result) const {
+    TransferFunction tf;
+    if (result.type == "Sealed") {
+        // 2nd-order high-pass at Fc, Qtc = Qts * Fc / Fs
+        double wc = 2.0 * PI * result.fc_or_fb;
+        double qtc = params.qts * result.fc_or_fb / params.fs;
+        tf.num = {0.0, 0.0, 1.0};
+        tf.den = {wc * wc, wc / qtc, 1.0};
+    } else if (result.type == "Bandpass") {
+        // 2nd-order band-pass around the tuning, Qbp = Qts * Fb / Fs
+        double w0 = 2.0 * PI * result.fc_or_fb;
+        double qbp = params.qts * result.fc_or_fb / params.fs;
+        tf.num = {0.0, w0 / qbp};
+        tf.den = {w0 * w0, w0 / qbp, 1.0};
+    } else if (result.type == "Ported" || result.type == "TransmissionLine" || result.type == "PassiveRadiator") {
+        // 4th-order vented high-pass, T0 = 1 / sqrt(ws * wb)
+        double h = result.fc_or_fb / params.fs;
+        double t0 = 1.0 / (2.0 * PI * params.fs * std::sqrt(h));
+        alignment::Coefficients c = alignment::ventedCoefficients(params.qts, h, result.alpha, result.ql > 0.0 ? 1.0 / result.ql : 0.0);
+        double t2 = t0 * t0;
+        tf.num = {0.0, 0.0, 0.0, 0.0, t2 * t2};
+        tf.den = {1.0, c.a3 * t0, c.a2 * t2, c.a1 * t2 * t0, t2 * t2};
+    }
+    return tf;
+}
+
+template <typename T>
+void Calculator::sizeCabinet(BasicEnclosureResult<T>& result, const BasicTSParameters<T>& params, const CabinetConstraints& constraints) const {
+    using std::sqrt;
+    T displaced = params.vd;  // liters
+    if (result.port_length > 0.0 && result.port_diameter > 0.0) {
+        T r = result.port_diameter / 2.0;
+        displaced = displaced + PI * r * r * result.port_length / 1000.0;
+    }
+    T cutout = constraints.cutout > 0.0 ? T(constraints.cutout / 10.0) : CUTOUT_PER_PISTON * 2.0 * sqrt(params.sd / PI);  // cm
+    BasicCabinet<T> cabinet = solveCabinet(result.vb, displaced, cutout, constraints);
+    result.width = cabinet.width;
+    result.height = cabinet.height;
+    result.depth = cabinet.depth;
+    result.outer_width = cabinet.outer_width;
+    result.outer_height = cabinet.outer_height;
+    result.outer_depth = cabinet.outer_depth;
+    result.displacement = displaced + cabinet.bracing;
+    if (!cabinet.fits) result.warnings.push_back(kOversizeWarning);
+    if (!cabinet.baffle_fits) result.warnings.push_back(kCutoutWarning);
+}
+
+template <typename T>
+T Calculator::calculatePortAirVelocity([[maybe_unused]] T sd, [[maybe_unused]] T xmax, [[maybe_unused]] T fb) const {
     // Basic: v = (Sd * Xmax * 2 * PI * fb) / port_area , but placeholder
     return 10.0;  // m/s example
 }
 
-bool Calculator::checkExcursion(double xmax) const {
+template <typename T>
+bool Calculator::checkExcursion([[maybe_unused]] T xmax) const {
     // Placeholder: assume power, calc excursion < xmax
     return true;
 }
 
-double Calculator::subtractDisplacements(double vb, const TSParameters& params, double port_vol) const {
-    double driver_disp = params.vd;  // liters
-    double bracing_disp = 0.5;  // assume
-    return vb - driver_disp - bracing_disp - port_vol;
-}
+template EnclosureResult Calculator::calculate<double>(const TSParameters&, EnclosureType, const std::map<std::string, double>&);
+template BasicEnclosureResult<float> Calculator::calculate<float>(const BasicTSParameters<float>&, EnclosureType, const std::map<std::string, double>&);
+template BasicEnclosureResult<Gradient> Calculator::calculate<Gradient>(const BasicTSParameters<Gradient>&, EnclosureType, const std::map<std::string, double>&);
+template EnclosureResult Calculator::calculateTuning<double>(const TSParameters&, EnclosureType, const std::map<std::string, double>&);
+template void Calculator::calculateGeometry<double>(EnclosureResult&, const TSParameters&, const std::map<std::string, double>&);
 
 }  // namespace speakerbox
@@ -1,4 +1,7 @@
 #include "config.h"
+#include "utils.h"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <sstream>
 #include <regex>
@@ -51,12 +54,83 @@ std::string Config::get(const std::string& key, const std::string& default_val)
 void Config::loadTSParameters(TSParameters& params) {
     params.fs = std::stod(get("fs", "0.0"));
     params.qts = std::stod(get("qts", "0.0"));
-    // ... load all
+    params.vas = std::stod(get("vas", "0.0"));
+    params.re = std::stod(get("re", "0.0"));
+    params.sd = std::stod(get("sd", "0.0"));
+    params.xmax = std::stod(get("xmax", "0.0"));
+    params.vd = std::stod(get("vd", "0.0"));
+    params.le = std::stod(get("le", "0.0"));
+    params.cms = std::stod(get("cms", "0.0"));
+    params.mms = std::stod(get("mms", "0.0"));
+    params.bl = std::stod(get("bl", "0.0"));
+}
+
+void Config::loadCabinetOptions(std::map<std::string, double>& options) const {
+    for (const auto& key : CabinetConstraints::optionKeys()) {
+        auto it = data_.find(key);
+        if (it != data_.end()) options[key] = std::stod(it->second);
+    }
 }
 
 void Config::saveTSParameters(const TSParameters& params) {
     set("fs", std::to_string(params.fs));
-    // ... save all
+    set("qts", std::to_string(params.qts));
+    set("vas", std::to_string(params.vas));
+    set("re", std::to_string(params.re));
+    set("sd", std::to_string(params.sd));
+    set("xmax", std::to_string(params.xmax));
+    set("vd", std::to_string(params.vd));
+    set("le", std::to_string(params.le));
+    set("cms", std::to_string(params.cms));
+    set("mms", std::to_string(params.mms));
+    set("bl", std::to_string(params.bl));
+}
+
+namespace {
+
+double TSParameters::*fieldByKey(const std::string& key) {
+    static const std::map<std::string, double TSParameters::*> fields = {
+        {"fs", &TSParameters::fs}, {"qts", &TSParameters::qts}, {"vas", &TSParameters::vas},
+        {"re", &TSParameters::re}, {"sd", &TSParameters::sd}, {"xmax", &TSParameters::xmax},
+        {"vd", &TSParameters::vd}, {"le", &TSParameters::le}, {"cms", &TSParameters::cms},
+        {"mms", &TSParameters::mms}, {"bl", &TSParameters::bl}
+    };
+    auto it = fields.find(key);
+    return it != fields.end() ? it->second : nullptr;
+}
+
+}  // namespace
+
+TSParametersReader::TSParametersReader(std::istream& in) : in_(in), ok_(false) {
+    std::string header;
+    if (!std::getline(in_, header)) return;
+    std::stringstream ss(header);
+    std::string key;
+    while (std::getline(ss, key, ',')) {
+        columns_.push_back(fieldByKey(trim(key)));
+        if (columns_.back()) ok_ = true;
+    }
+}
+
+std::size_t TSParametersReader::read(std::vector<TSParameters>& rows, std::size_t max_rows) {
+    rows.clear();
+    std::string line;
+    while (rows.size() < max_rows && std::getline(in_, line)) {
+        if (line.empty()) continue;
+        TSParameters params;
+        const char* p = line.data();
+        const char* end = p + line.size();
+        for (auto member : columns_) {
+            while (p < end && *p == ' ') ++p;
+            double value = 0.0;
+            auto res = std::from_chars(p, end, value);
+            if (member && res.ec == std::errc()) params.*member = value;
+            p = std::find(res.ptr, end, ',');
+            if (p < end) ++p;
+        }
+        rows.push_back(params);
+    }
+    return rows.size();
 }
 
 void initDataDir() {
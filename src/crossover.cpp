@@ -0,0 +1,331 @@
+#include "crossover.h"
+#include "constants.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace speakerbox {
+
+namespace {
+
+using Complex = std::complex<double>;
+
+constexpr double ERROR_RANGE = 40.0;  // dB below the target peak where the fit stops caring
+constexpr int MAX_ROUNDS = 200;
+
+constexpr double E6_VALUES[] = {1.0, 1.5, 2.2, 3.3, 4.7, 6.8};
+constexpr double E12_VALUES[] = {1.0, 1.2, 1.5, 1.8, 2.2, 2.7, 3.3, 3.9, 4.7, 5.6, 6.8, 8.2};
+constexpr double E24_VALUES[] = {1.0, 1.1, 1.2, 1.3, 1.5, 1.6, 1.8, 2.0, 2.2, 2.4, 2.7, 3.0,
+                                 3.3, 3.6, 3.9, 4.3, 4.7, 5.1, 5.6, 6.2, 6.8, 7.5, 8.2, 9.1};
+
+const double* seriesValues(ESeries series) {
+    switch (series) {
+        case ESeries::E6: return E6_VALUES;
+        case ESeries::E12: return E12_VALUES;
+        case ESeries::E24: return E24_VALUES;
+    }
+    return E12_VALUES;
+}
+
+// Preferred values counted up from 1.0: index n * decade + position
+int preferredIndex(double value, ESeries series) {
+    const int n = static_cast<int>(series);
+    const double* table = seriesValues(series);
+    int decade = static_cast<int>(std::floor(std::log10(value)));
+    double mantissa = value / std::pow(10.0, decade);
+    int best = n;  // 10.0, the next decade's first value
+    double best_distance = std::abs(std::log(mantissa / 10.0));
+    for (int i = 0; i < n; ++i) {
+        double distance = std::abs(std::log(mantissa / table[i]));
+        if (distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+    return decade * n + best;
+}
+
+double indexValue(int index, ESeries series) {
+    const int n = static_cast<int>(series);
+    int decade = index >= 0 ? index / n : -((-index + n - 1) / n);
+    return seriesValues(series)[index - decade * n] * std::pow(10.0, decade);
+}
+
+std::vector<double> multiply(const std::vector<double>& a, const std::vector<double>& b) {
+    std::vector<double> r(a.size() + b.size() - 1, 0.0);
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        for (std::size_t j = 0; j < b.size(); ++j) r[i + j] += a[i] * b[j];
+    }
+    return r;
+}
+
+// Normalized denominator, ascending powers of s / w0
+std::vector<double> prototype(int order) {
+    auto butterworth = [](int n) {
+        std::vector<double> d = {1.0};
+        for (int k = 1; k <= n / 2; ++k) d = multiply(d, {1.0, 2.0 * std::sin((2 * k - 1) * PI / (2.0 * n)), 1.0});
+        if (n % 2) d = multiply(d, {1.0, 1.0});
+        return d;
+    };
+    if (order % 2) return butterworth(order);
+    std::vector<double> half = butterworth(order / 2);
+    return multiply(half, half);
+}
+
+// Degree, ignoring leading terms that cancelled to rounding noise
+int degree(const std::vector<double>& c, double scale) {
+    for (int i = static_cast<int>(c.size()) - 1; i >= 0; --i) {
+        if (std::abs(c[i]) > 1e-9 * scale) return i;
+    }
+    return -1;
+}
+
+// Element values g of the lowpass ladder for 1 / D(s) into a 1 ohm load, amplifier end first.
+// The admittance seen from the load is m / n (even and odd parts of D), expanded as a continued fraction.
+std::vector<double> synthesize(const std::vector<double>& d) {
+    std::vector<double> even(d.size(), 0.0), odd(d.size(), 0.0);
+    for (std::size_t i = 0; i < d.size(); ++i) (i % 2 ? odd : even)[i] = d[i];
+    double scale = *std::max_element(d.begin(), d.end());
+    std::vector<double> num = even, den = odd;
+    if (degree(num, scale) < degree(den, scale)) std::swap(num, den);
+    std::vector<double> g;
+    while (degree(den, scale) >= 0) {
+        int dn = degree(num, scale), dd = degree(den, scale);
+        double value = num[dn] / den[dd];
+        g.push_back(value);
+        for (int i = 0; i <= dd; ++i) num[i + 1] -= value * den[i];
+        num[dn] = 0.0;
+        std::swap(num, den);
+    }
+    std::reverse(g.begin(), g.end());
+    return g;
+}
+
+}  // namespace
+
+double preferredValue(double value, ESeries series) {
+    if (value <= 0.0) return 0.0;
+    return indexValue(preferredIndex(value, series), series);
+}
+
+CrossoverTarget::CrossoverTarget()
+    : kind(FilterKind::LowPass), order(4), frequency(2000.0), level(0.0), zobel(true), reactive_series(ESeries::E12),
+      resistor_series(ESeries::E24) {}
+
+Crossover::Crossover(const TSParameters& params, const EnclosureResult& result, std::size_t points, double f_min, double f_max)
+    : re_(params.re), le_(params.le * 1e-3) {
+    if (params.fs <= 0.0 || params.qts <= 0.0 || params.sd <= 0.0 || params.re <= 0.0 || points < 2 || f_min <= 0.0 || f_max <= f_min) return;
+
+    // Mechanical side in SI units, damped as in the simulator
+    TSParameters full = completeParameters(params);
+    const double sd = params.sd * 1e-4, mms = full.mms * 1e-3, cms = full.cms, bl = full.bl;
+    const double rms = mechanicalResistance(full);
+
+    // Box compliance, in parallel with the vent mass when the box is tuned
+    double k_box = 0.0, map = 0.0, rap = 0.0;
+    if (result.vb > 0.0) {
+        k_box = AIR_DENSITY * SPEED_SOUND * SPEED_SOUND / (result.vb * 1e-3);
+        if (result.type != "Sealed" && result.fc_or_fb > 0.0) {
+            double wb = 2.0 * PI * result.fc_or_fb;
+            map = k_box / (wb * wb);
+            rap = result.ql > 0.0 ? wb * map / result.ql : 0.0;
+        }
+    }
+
+    Calculator calc;
+    TransferFunction tf = calc.transferFunction(params, result);
+    freqs_.resize(points);
+    driver_.resize(points);
+    acoustic_.resize(points);
+    const double step = std::log(f_max / f_min) / (points - 1);
+    for (std::size_t k = 0; k < points; ++k) {
+        double f = f_min * std::exp(step * k);
+        Complex s(0.0, 2.0 * PI * f);
+        Complex zm = rms + s * mms + 1.0 / (s * cms);
+        if (k_box > 0.0) {
+            Complex y_box = s / k_box;
+            if (map > 0.0) y_box += 1.0 / (rap + s * map);
+            zm += sd * sd / y_box;
+        }
+        Complex blocked = re_ + s * le_;
+        freqs_[k] = f;
+        driver_[k] = blocked + bl * bl / zm;
+        // The enclosure model assumes a resistive coil; Le rolls the top off
+        acoustic_[k] = (tf.den.empty() ? Complex(1.0) : tf.evaluate(f)) * re_ / blocked;
+    }
+}
+
+CrossoverDesign Crossover::design(const CrossoverTarget& target) const {
+    CrossoverDesign design{target.kind, {}, 0.0, 0.0, 0.0, 0.0};
+    const double w0 = 2.0 * PI * target.frequency, r = re_;
+    std::vector<double> g = synthesize(prototype(std::max(1, std::min(4, target.order))));
+    for (std::size_t i = 0; i < g.size(); ++i) {
+        bool series = i % 2 == 0;
+        double value;
+        if (target.kind == FilterKind::LowPass) value = series ? g[i] * r / w0 : g[i] / (r * w0);
+        else value = series ? 1.0 / (g[i] * r * w0) : r / (g[i] * w0);
+        design.ladder.push_back(value);
+    }
+    if (target.level < 0.0) {
+        double a = std::pow(10.0, target.level / 20.0);
+        design.pad_series = r * (1.0 - a);
+        design.pad_shunt = r * a / (1.0 - a);
+    }
+    if (target.zobel && le_ > 0.0) {
+        design.zobel_r = re_;
+        design.zobel_c = le_ / (re_ * re_);
+    }
+    return design;
+}
+
+std::vector<double> Crossover::targetCurve(const CrossoverTarget& target) const {
+    std::vector<double> d = prototype(std::max(1, std::min(4, target.order)));
+    std::vector<double> db(freqs_.size());
+    for (std::size_t k = 0; k < freqs_.size(); ++k) {
+        double x = freqs_[k] / target.frequency;
+        Complex s = target.kind == FilterKind::LowPass ? Complex(0.0, x) : Complex(0.0, -1.0 / x);
+        Complex den = 0.0;
+        for (auto it = d.rbegin(); it != d.rend(); ++it) den = den * s + *it;
+        // Enclosure response without Le: the network is expected to absorb the coil's roll-off
+        Complex enclosure = acoustic_[k] * (re_ + Complex(0.0, 2.0 * PI * freqs_[k]) * le_) / re_;
+        db[k] = 20.0 * std::log10(std::abs(enclosure / den)) + target.level;
+    }
+    return db;
+}
+
+std::complex<double> Crossover::transfer(const CrossoverDesign& design, std::size_t k, std::complex<double>* input_impedance) const {
+    const Complex s(0.0, 2.0 * PI * freqs_[k]);
+    Complex load = driver_[k];
+    if (design.zobel_r > 0.0 && design.zobel_c > 0.0) {
+        Complex zobel = design.zobel_r + 1.0 / (s * design.zobel_c);
+        load = load * zobel / (load + zobel);
+    }
+    // Walk back from the driver at 1 V, accumulating voltage and current
+    Complex v = 1.0, i = 1.0 / load;
+    if (design.pad_shunt > 0.0) i += v / design.pad_shunt;
+    v += i * design.pad_series;
+    const bool low = design.kind == FilterKind::LowPass;
+    for (std::size_t e = design.ladder.size(); e-- > 0;) {
+        double value = design.ladder[e];
+        if (e % 2 == 0) v += i * (low ? s * value : 1.0 / (s * value));
+        else i += v * (low ? s * value : 1.0 / (s * value));
+    }
+    if (input_impedance) *input_impedance = v / i;
+    return 1.0 / v;
+}
+
+double Crossover::error(const CrossoverDesign& design, const std::vector<double>& target, double floor) const {
+    double sum = 0.0;
+    for (std::size_t k = 0; k < freqs_.size(); ++k) {
+        double db = 10.0 * std::log10(std::norm(acoustic_[k] * transfer(design, k, nullptr)));
+        double diff = std::max(db, floor) - std::max(target[k], floor);
+        sum += diff * diff;
+    }
+    return std::sqrt(sum / freqs_.size());
+}
+
+CrossoverResponse Crossover::simulate(const CrossoverDesign& design) const {
+    CrossoverResponse response{};
+    response.min_impedance = HUGE_VAL;
+    for (std::size_t k = 0; k < freqs_.size(); ++k) {
+        Complex zin;
+        Complex p = acoustic_[k] * transfer(design, k, &zin);
+        response.spl.push_back(20.0 * std::log10(std::abs(p)));
+        response.phase.push_back(std::arg(p) * 180.0 / PI);
+        response.impedance.push_back(std::abs(zin));
+        if (response.impedance.back() < response.min_impedance) {
+            response.min_impedance = response.impedance.back();
+            response.min_impedance_freq = freqs_[k];
+        }
+    }
+    return response;
+}
+
+CrossoverOptimization Crossover::optimize(const CrossoverTarget& target) const {
+    CrossoverOptimization opt{};
+    opt.nominal = design(target);
+    const std::vector<double> curve = targetCurve(target);
+    const double floor = *std::max_element(curve.begin(), curve.end()) - ERROR_RANGE;
+    opt.nominal_error = error(opt.nominal, curve, floor);
+
+    // Every component present in the nominal design becomes one preferred-value index
+    struct Part {
+        double CrossoverDesign::*field;  // nullptr for a ladder element
+        std::size_t element;
+        ESeries series;
+    };
+    std::vector<Part> parts;
+    for (std::size_t e = 0; e < opt.nominal.ladder.size(); ++e) parts.push_back({nullptr, e, target.reactive_series});
+    if (opt.nominal.pad_series > 0.0) {
+        parts.push_back({&CrossoverDesign::pad_series, 0, target.resistor_series});
+        parts.push_back({&CrossoverDesign::pad_shunt, 0, target.resistor_series});
+    }
+    if (opt.nominal.zobel_r > 0.0) {
+        parts.push_back({&CrossoverDesign::zobel_r, 0, target.resistor_series});
+        parts.push_back({&CrossoverDesign::zobel_c, 0, target.reactive_series});
+    }
+    const std::size_t dims = parts.size();
+    auto toDesign = [&](const int* index, CrossoverDesign& out) {
+        for (std::size_t p = 0; p < dims; ++p) {
+            double value = indexValue(index[p], parts[p].series);
+            if (parts[p].field) out.*parts[p].field = value;
+            else out.ladder[parts[p].element] = value;
+        }
+    };
+    std::vector<int> current(dims);
+    for (std::size_t p = 0; p < dims; ++p) {
+        double value = parts[p].field ? opt.nominal.*parts[p].field : opt.nominal.ladder[parts[p].element];
+        current[p] = preferredIndex(value, parts[p].series);
+    }
+    opt.design = opt.nominal;
+    toDesign(current.data(), opt.design);
+    opt.error = error(opt.design, curve, floor);
+    opt.evaluations = 1;
+
+    // Neighbourhood: one part by +-1 or +-2 steps, or two parts by one step each
+    std::vector<std::pair<int, int>> moves;  // Parts moved; second -1 for single moves
+    std::vector<int> deltas;  // Steps, two per move
+    for (std::size_t p = 0; p < dims; ++p) {
+        for (int step : {-2, -1, 1, 2}) {
+            moves.push_back({static_cast<int>(p), -1});
+            deltas.push_back(step);
+            deltas.push_back(0);
+        }
+        for (std::size_t q = p + 1; q < dims; ++q) {
+            for (int a : {-1, 1}) {
+                for (int b : {-1, 1}) {
+                    moves.push_back({static_cast<int>(p), static_cast<int>(q)});
+                    deltas.push_back(a);
+                    deltas.push_back(b);
+                }
+            }
+        }
+    }
+    const std::size_t count = moves.size();
+    std::vector<double> scores(count);
+
+    for (int round = 0; round < MAX_ROUNDS && count > 0; ++round) {
+        parallelFor(count, 16, [&](std::size_t begin, std::size_t end) {
+            CrossoverDesign candidate = opt.design;
+            std::vector<int> index(dims);
+            for (std::size_t c = begin; c < end; ++c) {
+                index = current;
+                index[moves[c].first] += deltas[2 * c];
+                if (moves[c].second >= 0) index[moves[c].second] += deltas[2 * c + 1];
+                toDesign(index.data(), candidate);
+                scores[c] = error(candidate, curve, floor);
+            }
+        });
+        opt.evaluations += count;
+
+        std::size_t best = std::min_element(scores.begin(), scores.end()) - scores.begin();
+        if (!(scores[best] < opt.error - 1e-9)) break;
+        current[moves[best].first] += deltas[2 * best];
+        if (moves[best].second >= 0) current[moves[best].second] += deltas[2 * best + 1];
+        toDesign(current.data(), opt.design);
+        opt.error = scores[best];
+    }
+    return opt;
+}
+
+}  // namespace speakerbox
@@ -0,0 +1,219 @@
+#include "cutlist.h"
+#include "parallel.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <random>
+
+namespace speakerbox {
+
+namespace {
+
+constexpr std::size_t kFixedVariants = 16;  // Sort key x fit rule x split rule, before any jitter
+constexpr double kJitter = 0.2;  // Relative spread of the sort key in random attempts
+
+struct Rect {
+    double x, y, w, h;
+};
+
+struct Sheet {
+    std::vector<Rect> free;  // Disjoint; every one reachable by guillotine cuts
+    double used;  // mm^2 of panels
+};
+
+// Sheets that can still take a panel, with the bounds every placement checks
+// first kept in flat arrays: most sheets are ruled out without touching them
+struct OpenSheets {
+    std::vector<std::size_t> sheet;
+    std::vector<double> free_area;  // Kerf included
+    std::vector<double> max_w, max_h;  // Widest and tallest free rectangle
+
+    void erase(std::size_t k) {
+        sheet.erase(sheet.begin() + k);
+        free_area.erase(free_area.begin() + k);
+        max_w.erase(max_w.begin() + k);
+        max_h.erase(max_h.begin() + k);
+    }
+};
+
+bool better(const CutList& a, std::size_t a_index, const CutList& b, std::size_t b_index) {
+    if (a.sheets != b.sheets) return a.sheets < b.sheets;
+    if (a.smallest_fill != b.smallest_fill) return a.smallest_fill < b.smallest_fill;
+    return a_index < b_index;
+}
+
+}  // namespace
+
+std::vector<Panel> cabinetPanels(const EnclosureResult& result, const CabinetConstraints& constraints, std::size_t cabinet) {
+    std::vector<Panel> panels;
+    const double t = constraints.panel;  // mm
+    const double w = result.outer_width * 10.0, h = result.outer_height * 10.0, d = result.outer_depth * 10.0;
+    if (w <= 2.0 * t || h <= 2.0 * t || d <= 2.0 * t) return panels;
+    panels.push_back({cabinet, "Front", w, h});
+    panels.push_back({cabinet, "Back", w, h});
+    panels.push_back({cabinet, "Side", d - 2.0 * t, h});
+    panels.push_back({cabinet, "Side", d - 2.0 * t, h});
+    panels.push_back({cabinet, "Top", w - 2.0 * t, d - 2.0 * t});
+    panels.push_back({cabinet, "Bottom", w - 2.0 * t, d - 2.0 * t});
+    for (int i = 0; i < constraints.braces; ++i) panels.push_back({cabinet, "Brace", result.width * 10.0, result.depth * 10.0});
+    return panels;
+}
+
+CutListOptions::CutListOptions() : sheet_width(2440.0), sheet_height(1220.0), kerf(3.0), trim(10.0), rotate(true), attempts(64), workers(0) {}
+
+CutListOptimizer::CutListOptimizer(const CutListOptions& options) : options_(options) {}
+
+CutList CutListOptimizer::optimize(const std::vector<Panel>& panels) const {
+    const std::size_t attempts = std::max<std::size_t>(1, options_.attempts);
+    CutList best;
+    std::size_t best_index = attempts;
+    std::mutex mutex;
+    parallelFor(attempts, 1, [&](std::size_t begin, std::size_t end) {
+        CutList local;
+        std::size_t local_index = attempts;
+        for (std::size_t i = begin; i < end; ++i) {
+            CutList list = attempt(panels, i);
+            if (local_index == attempts || better(list, i, local, local_index)) {
+                local = std::move(list);
+                local_index = i;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (best_index == attempts || better(local, local_index, best, best_index)) {
+            best = std::move(local);
+            best_index = local_index;
+        }
+    }, options_.workers);
+    return best;
+}
+
+CutList CutListOptimizer::attempt(const std::vector<Panel>& panels, std::size_t index) const {
+    // Each panel carries one kerf on its far edges; the sheet gets one back for the last cut
+    const double kerf = options_.kerf;
+    const double sheet_w = options_.sheet_width - 2.0 * options_.trim + kerf;
+    const double sheet_h = options_.sheet_height - 2.0 * options_.trim + kerf;
+    const int sort_key = static_cast<int>(index % 4);
+    const bool area_fit = (index / 4) % 2 == 1;
+    const bool shorter_axis = (index / 8) % 2 == 0;
+
+    std::vector<double> key(panels.size());
+    std::mt19937 rng(static_cast<unsigned>(index));
+    std::uniform_real_distribution<double> jitter(1.0 - kJitter, 1.0 + kJitter);
+    for (std::size_t i = 0; i < panels.size(); ++i) {
+        double w = panels[i].width, h = panels[i].height;
+        switch (sort_key) {
+            case 0: key[i] = w * h; break;
+            case 1: key[i] = std::max(w, h); break;
+            case 2: key[i] = w + h; break;
+            default: key[i] = std::min(w, h); break;
+        }
+        if (index >= kFixedVariants) key[i] *= jitter(rng);
+    }
+    std::vector<std::size_t> order(panels.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return key[a] > key[b]; });
+
+    // Offcuts narrower than any panel are waste from the start; sheets left with none drop out of the search
+    double min_w = std::numeric_limits<double>::max(), min_h = min_w;
+    for (const Panel& panel : panels) {
+        double w = options_.rotate ? std::min(panel.width, panel.height) : panel.width;
+        double h = options_.rotate ? w : panel.height;
+        min_w = std::min(min_w, w + kerf);
+        min_h = std::min(min_h, h + kerf);
+    }
+
+    CutList list{};
+    std::vector<Sheet> sheets;
+    OpenSheets open;
+    for (std::size_t p : order) {
+        const double iw = panels[p].width + kerf, ih = panels[p].height + kerf;
+        const bool upright = iw <= sheet_w && ih <= sheet_h;
+        const bool turned = options_.rotate && ih <= sheet_w && iw <= sheet_h;
+        if (!(panels[p].width > 0.0 && panels[p].height > 0.0) || (!upright && !turned)) {
+            list.unplaced.push_back(p);
+            continue;
+        }
+
+        // Tightest fit: leftover area or shorter leftover side first, the other side breaking ties
+        std::size_t best_slot = open.sheet.size(), best_rect = 0;
+        bool best_rotated = false;
+        double best_primary = std::numeric_limits<double>::max(), best_secondary = best_primary;
+        auto search = [&](std::size_t k) {
+            const Sheet& sheet = sheets[open.sheet[k]];
+            for (std::size_t r = 0; r < sheet.free.size(); ++r) {
+                const Rect& f = sheet.free[r];
+                for (int turn = 0; turn < (options_.rotate && iw != ih ? 2 : 1); ++turn) {
+                    double pw = turn ? ih : iw, ph = turn ? iw : ih;
+                    if (pw > f.w || ph > f.h) continue;
+                    double dw = f.w - pw, dh = f.h - ph;
+                    double primary = area_fit ? f.w * f.h - pw * ph : std::min(dw, dh);
+                    double secondary = area_fit ? std::min(dw, dh) : std::max(dw, dh);
+                    if (primary < best_primary || (primary == best_primary && secondary < best_secondary)) {
+                        best_primary = primary;
+                        best_secondary = secondary;
+                        best_slot = k;
+                        best_rect = r;
+                        best_rotated = turn == 1;
+                    }
+                }
+            }
+        };
+        const double area = iw * ih;
+        for (std::size_t k = 0; k < open.sheet.size(); ++k) {
+            if (open.free_area[k] < area) continue;
+            if ((open.max_w[k] >= iw && open.max_h[k] >= ih) || (options_.rotate && open.max_w[k] >= ih && open.max_h[k] >= iw)) search(k);
+        }
+        if (best_slot == open.sheet.size()) {
+            sheets.push_back({{{0.0, 0.0, sheet_w, sheet_h}}, 0.0});
+            open.sheet.push_back(sheets.size() - 1);
+            open.free_area.push_back(sheet_w * sheet_h);
+            open.max_w.push_back(sheet_w);
+            open.max_h.push_back(sheet_h);
+            search(best_slot);
+        }
+
+        // One cut across the leftover, then one more to free the panel
+        const std::size_t best_sheet = open.sheet[best_slot];
+        Sheet& sheet = sheets[best_sheet];
+        Rect f = sheet.free[best_rect];
+        sheet.free[best_rect] = sheet.free.back();
+        sheet.free.pop_back();
+        const double pw = best_rotated ? ih : iw, ph = best_rotated ? iw : ih;
+        const double dw = f.w - pw, dh = f.h - ph;
+        bool across = shorter_axis ? dw < dh : pw * dh > dw * ph;  // Full-width strip above the panel
+        Rect right = {f.x + pw, f.y, dw, across ? ph : f.h};
+        Rect above = {f.x, f.y + ph, across ? f.w : pw, dh};
+        open.free_area[best_slot] -= pw * ph;
+        for (const Rect& r : {right, above}) {
+            if (r.w >= min_w && r.h >= min_h) {
+                sheet.free.push_back(r);
+            } else {
+                open.free_area[best_slot] -= r.w * r.h;
+            }
+        }
+        open.max_w[best_slot] = open.max_h[best_slot] = 0.0;
+        for (const Rect& r : sheet.free) {
+            open.max_w[best_slot] = std::max(open.max_w[best_slot], r.w);
+            open.max_h[best_slot] = std::max(open.max_h[best_slot], r.h);
+        }
+        if (sheet.free.empty()) open.erase(best_slot);
+        sheet.used += panels[p].width * panels[p].height;
+        list.placements.push_back({p, best_sheet, f.x + options_.trim, f.y + options_.trim, best_rotated});
+    }
+
+    list.sheets = sheets.size();
+    const double sheet_area = options_.sheet_width * options_.sheet_height;
+    double used = 0.0;
+    list.smallest_fill = sheets.empty() ? 0.0 : 1.0;
+    for (const Sheet& sheet : sheets) {
+        used += sheet.used;
+        list.smallest_fill = std::min(list.smallest_fill, sheet.used / sheet_area);
+    }
+    list.waste = sheets.empty() ? 0.0 : 1.0 - used / (list.sheets * sheet_area);
+    std::stable_sort(list.placements.begin(), list.placements.end(),
+                     [](const Placement& a, const Placement& b) { return a.sheet < b.sheet; });
+    return list;
+}
+
+}  // namespace speakerbox
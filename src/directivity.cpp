@@ -0,0 +1,248 @@
+#include "directivity.h"
+#include "constants.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace speakerbox {
+
+namespace {
+
+constexpr double DEFAULT_QL = 7.0;  // Vent losses when the result has none
+constexpr double SHADOW_BAND = 20.0;  // Degrees either side of the baffle plane where the cone's direct sound fades out
+constexpr double ROUND_MAGIC = 6755399441055744.0;  // 1.5 * 2^52: x + M - M rounds to nearest without a call
+constexpr double TWO_OVER_PI = 0.636619772367581343;
+constexpr double PIO2_HI = 1.57079632673412561417;  // Cody-Waite split of pi / 2
+constexpr double PIO2_LO = 6.07710050650619224932e-11;
+
+// sin and cos to ~1e-10 for |x| up to a few thousand radians
+inline void sinCos(double x, double& s, double& c) {
+    double q = (x * TWO_OVER_PI + ROUND_MAGIC) - ROUND_MAGIC;
+    double r = (x - q * PIO2_HI) - q * PIO2_LO;
+    double m = q - 4.0 * ((q * 0.25 + ROUND_MAGIC) - ROUND_MAGIC);  // Quadrant, -2 to 2
+    double r2 = r * r;
+    double sr = r + r * r2 * (-1.0 / 6 + r2 * (1.0 / 120 + r2 * (-1.0 / 5040 + r2 * (1.0 / 362880 + r2 * (-1.0 / 39916800)))));
+    double cr = 1.0 + r2 * (-0.5 + r2 * (1.0 / 24 + r2 * (-1.0 / 720 + r2 * (1.0 / 40320 + r2 * (-1.0 / 3628800 + r2 * (1.0 / 479001600))))));
+    bool odd = m == 1.0 || m == -1.0;
+    double s0 = odd ? cr : sr, c0 = odd ? sr : cr;
+    s = m == 0.0 || m == 1.0 ? s0 : -s0;
+    c = m == 0.0 || m == -1.0 ? c0 : -c0;
+}
+
+// 2 J1(x) / x for x >= 0, rational fit below 8 and the Hankel asymptotic above
+// (Numerical Recipes' bessj1); both are evaluated and blended, without branches.
+// rsqrt is 1 / sqrt(x) (used from 8 up), which callers build from separable
+// factors so that loops over angles make no library calls.
+inline double piston(double x, double rsqrt) {
+    // 1 below 8, else 0; an ordered compare may trap, which would keep GCC from vectorizing
+    double w = 0.5 + std::copysign(0.5, 8.0 - x);
+    double xs = w * x + (1.0 - w) * 8.0, y = xs * xs;
+    double p = 72362614232.0 + y * (-7895059235.0 + y * (242396853.1 + y * (-2972611.439 + y * (15704.48260 + y * (-30.16036606)))));
+    double q = 144725228442.0 + y * (2300535178.0 + y * (18583304.74 + y * (99447.43394 + y * (376.9991397 + y))));
+    double small = 2.0 * p / q;
+
+    double xl = (1.0 - w) * x + w * 8.0, z = 8.0 / xl, z2 = z * z;
+    double a = 1.0 + z2 * (0.183105e-2 + z2 * (-0.3516396496e-4 + z2 * (0.2457520174e-5 + z2 * (-0.240337019e-6))));
+    double b = 0.04687499995 + z2 * (-0.2002690873e-3 + z2 * (0.8449199096e-5 + z2 * (-0.88228987e-6 + z2 * 0.105787412e-6)));
+    double s, c;
+    sinCos(xl - 2.356194491, s, c);
+    double large = 2.0 * 0.797884561 * rsqrt * (c * a - z * s * b) / xl;  // sqrt(2 / pi)
+    return w * small + (1.0 - w) * large;
+}
+
+constexpr std::size_t RAYS = DirectivityModel::kEdgePoints / 2;
+
+// Sources sit on the baffle's vertical centre line, so the rays to its edges
+// come in mirror pairs; only the right-hand ray of each pair is kept
+struct Source {
+    double y;  // m, up from the bottom of the baffle
+    double radius;  // m
+    double edge_r[RAYS];  // Distance to the baffle edge
+    double edge_dx[RAYS];  // Horizontal offset of that edge point
+};
+
+Source makeSource(double y, double radius, double width, double height) {
+    Source src{y, radius, {}, {}};
+    for (std::size_t m = 0; m < RAYS; ++m) {
+        double phi = PI * ((m + 0.5) / RAYS - 0.5);
+        double dx = std::cos(phi), dy = std::sin(phi);
+        double t = width / 2.0 / dx;
+        if (dy > 0.0) t = std::min(t, (height - y) / dy);
+        if (dy < 0.0) t = std::min(t, -y / dy);
+        src.edge_r[m] = t;
+        src.edge_dx[m] = t * dx;
+    }
+    return src;
+}
+
+}  // namespace
+
+DirectivityModel::DirectivityModel(std::size_t freq_points, std::size_t angle_points, double f_min, double f_max) {
+    if (!(f_min > 0.0) || !(f_max > f_min)) return;
+    freq_points = std::max<std::size_t>(freq_points, 2);
+    angle_points = std::max<std::size_t>(angle_points, 2);
+    const double step = std::log(f_max / f_min) / (freq_points - 1);
+    for (std::size_t i = 0; i < freq_points; ++i) freqs_.push_back(f_min * std::exp(step * i));
+    const double dt = PI / (angle_points - 1);
+    for (std::size_t j = 0; j < angle_points; ++j) {
+        double t = j * dt;
+        angles_.push_back(t * 180.0 / PI);
+        sin_.push_back(std::sin(t));
+        rsqrt_sin_.push_back(sin_.back() > 0.0 ? 1.0 / std::sqrt(sin_.back()) : 0.0);
+        // Raised-cosine fade, so the field has no step at the shadow boundary
+        double off = std::clamp((t - PI / 2.0) / (SHADOW_BAND * PI / 180.0), -1.0, 1.0);
+        direct_.push_back(0.5 - 0.5 * std::sin(off * PI / 2.0));
+        double end = j == 0 || j + 1 == angle_points ? 0.5 : 1.0;
+        solid_.push_back(end * std::sin(t) * dt / 2.0);
+    }
+}
+
+DirectivityModel::Workspace DirectivityModel::makeWorkspace() const {
+    const std::size_t n = angles_.size();
+    Workspace ws;
+    ws.re.resize(n);
+    ws.im.resize(n);
+    ws.edge_re.resize(n);
+    ws.edge_im.resize(n);
+    ws.piston.resize(n);
+    return ws;
+}
+
+PolarMap DirectivityModel::compute(const TSParameters& params, const EnclosureResult& result) const {
+    PolarMap map;
+    map.freqs = freqs_;
+    map.angles = angles_;
+    std::vector<double> spl(freqs_.size() * angles_.size()), di(freqs_.size());
+    Workspace ws = makeWorkspace();
+    if (fill(params, result, ws, spl.data(), di.data())) {
+        map.spl = std::move(spl);
+        map.di = std::move(di);
+    }
+    return map;
+}
+
+bool DirectivityModel::fill(const TSParameters& params, const EnclosureResult& result, Workspace& ws, double* spl, double* di) const {
+    const double width = result.outer_width * 0.01, height = result.outer_height * 0.01;
+    if (!ok() || params.sd <= 0.0 || width <= 0.0 || height <= 0.0) return false;
+
+    // Driver two thirds up the baffle; the vent (or radiator, or line mouth) below it
+    const double cone = std::sqrt(params.sd * 1e-4 / PI);
+    Source sources[2];
+    std::size_t count = 0;
+    bool cone_radiates = result.type != "Bandpass";
+    bool vent = result.type != "Sealed" && result.fc_or_fb > 0.0;
+    if (cone_radiates) sources[count++] = makeSource(height * 2.0 / 3.0, cone, width, height);
+    if (vent) {
+        double radius = result.port_diameter > 0.0 ? result.port_diameter * 0.005 : cone;
+        double y = cone_radiates ? std::min(height / 5.0, height * 2.0 / 3.0 - cone - radius) : height * 2.0 / 3.0;
+        sources[count++] = makeSource(std::max(y, radius), radius, width, height);
+    }
+    const double wb = 2.0 * PI * result.fc_or_fb, ql = result.ql > 0.0 ? result.ql : DEFAULT_QL;
+
+    const std::size_t n = angles_.size();
+    const double pair_weight = 2.0 / kEdgePoints;
+    for (std::size_t i = 0; i < freqs_.size(); ++i) {
+        const double k = 2.0 * PI * freqs_[i] / SPEED_SOUND;
+        std::fill(ws.re.begin(), ws.re.end(), 0.0);
+        std::fill(ws.im.begin(), ws.im.end(), 0.0);
+        for (std::size_t src = 0; src < count; ++src) {
+            const Source& s = sources[src];
+            // Volume velocity against the cone's: the vent's rises through Fb and cancels the cone below it
+            std::complex<double> strength = 1.0;
+            if (vent && (src == 1 || !cone_radiates)) {
+                std::complex<double> sn(0.0, 2.0 * PI * freqs_[i] / wb);
+                strength = -1.0 / (1.0 + sn / ql + sn * sn);
+            }
+
+            const double ka = k * s.radius, rsqrt_ka = 1.0 / std::sqrt(ka);
+            for (std::size_t j = 0; j < n; ++j) ws.piston[j] = piston(ka * sin_[j], rsqrt_ka * rsqrt_sin_[j]);
+            std::fill(ws.edge_re.begin(), ws.edge_re.end(), 0.0);
+            std::fill(ws.edge_im.begin(), ws.edge_im.end(), 0.0);
+            for (std::size_t m = 0; m < RAYS; ++m) {
+                // Along the baffle to the edge, then the far-field path shortened (or, for the
+                // mirror ray, lengthened) by the edge's offset: 2 cos(k dx sin t) e^(-jkr) per pair
+                const double kdx = k * s.edge_dx[m];
+                double sr, cr;
+                sinCos(k * s.edge_r[m], sr, cr);
+                for (std::size_t j = 0; j < n; ++j) {
+                    double sn, cs;
+                    sinCos(kdx * sin_[j], sn, cs);
+                    ws.edge_re[j] += cs * cr;
+                    ws.edge_im[j] -= cs * sr;
+                }
+            }
+            const double grazing = piston(ka, rsqrt_ka) * pair_weight;
+            const double sr = strength.real(), si = strength.imag();
+            for (std::size_t j = 0; j < n; ++j) {
+                double edge = (0.5 - direct_[j]) * grazing;
+                double p_re = direct_[j] * ws.piston[j] + edge * ws.edge_re[j];
+                double p_im = edge * ws.edge_im[j];
+                ws.re[j] += sr * p_re - si * p_im;
+                ws.im[j] += sr * p_im + si * p_re;
+            }
+        }
+
+        double* row = spl + i * n;
+        double power = 0.0;
+        for (std::size_t j = 0; j < n; ++j) {
+            double p2 = ws.re[j] * ws.re[j] + ws.im[j] * ws.im[j];
+            power += solid_[j] * p2;
+            row[j] = 10.0 * std::log10(std::max(p2, 1e-20));
+        }
+        di[i] = row[0] - 10.0 * std::log10(std::max(power, 1e-20));
+    }
+    return true;
+}
+
+DirectivityMetrics DirectivityModel::metrics(const PolarMap& map) const {
+    DirectivityMetrics metrics{};
+    if (map.spl.empty()) return metrics;
+    // DI at a frequency, linear in log frequency between grid points
+    auto diAt = [&](double f) {
+        auto it = std::lower_bound(map.freqs.begin(), map.freqs.end(), f);
+        if (it == map.freqs.begin()) return map.di.front();
+        if (it == map.freqs.end()) return map.di.back();
+        std::size_t i = it - map.freqs.begin();
+        double t = std::log(f / map.freqs[i - 1]) / std::log(map.freqs[i] / map.freqs[i - 1]);
+        return map.di[i - 1] + t * (map.di[i] - map.di[i - 1]);
+    };
+    metrics.di_1k = diAt(1000.0);
+    metrics.di_10k = diAt(10000.0);
+
+    const std::size_t at45 = static_cast<std::size_t>(std::lround(45.0 / 180.0 * (map.angles.size() - 1)));
+    double low = HUGE_VAL, high = -HUGE_VAL;
+    for (std::size_t i = 0; i < map.freqs.size(); ++i) {
+        if (metrics.beaming_freq == 0.0 && map.at(i, at45) <= map.at(i, 0) - 6.0) metrics.beaming_freq = map.freqs[i];
+        if (map.freqs[i] >= 100.0 && map.freqs[i] <= 5000.0) {
+            low = std::min(low, map.at(i, 0));
+            high = std::max(high, map.at(i, 0));
+        }
+    }
+    if (high >= low) metrics.on_axis_span = high - low;
+    return metrics;
+}
+
+std::vector<DirectivityMetrics> DirectivityModel::analyzeBatch(const std::vector<TSParameters>& params,
+                                                               const std::vector<EnclosureResult>& results) const {
+    std::size_t count = std::min(params.size(), results.size());
+    std::vector<DirectivityMetrics> metrics(count);
+    parallelFor(count, 4, [&](std::size_t begin, std::size_t end) {
+        Workspace ws = makeWorkspace();
+        PolarMap map;
+        map.freqs = freqs_;
+        map.angles = angles_;
+        std::vector<double> spl(freqs_.size() * angles_.size()), di(freqs_.size());
+        for (std::size_t i = begin; i < end; ++i) {
+            if (!fill(params[i], results[i], ws, spl.data(), di.data())) continue;
+            map.spl.swap(spl);
+            map.di.swap(di);
+            metrics[i] = this->metrics(map);
+            map.spl.swap(spl);
+            map.di.swap(di);
+        }
+    });
+    return metrics;
+}
+
+}  // namespace speakerbox
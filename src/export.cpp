@@ -0,0 +1,392 @@
+#include "export.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#ifdef SPEAKERBOX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace speakerbox {
+
+namespace {
+
+struct Column {
+    const char* name;
+    double EnclosureResult::*member;
+};
+
+// Numeric columns shared by every format, in output order
+constexpr Column kColumns[] = {
+    {"vb", &EnclosureResult::vb},
+    {"fc_or_fb", &EnclosureResult::fc_or_fb},
+    {"port_length", &EnclosureResult::port_length},
+    {"port_diameter", &EnclosureResult::port_diameter},
+    {"air_velocity", &EnclosureResult::air_velocity},
+    {"alpha", &EnclosureResult::alpha},
+    {"ql", &EnclosureResult::ql},
+    {"width", &EnclosureResult::width},
+    {"height", &EnclosureResult::height},
+    {"depth", &EnclosureResult::depth},
+    {"outer_width", &EnclosureResult::outer_width},
+    {"outer_height", &EnclosureResult::outer_height},
+    {"outer_depth", &EnclosureResult::outer_depth},
+    {"displacement", &EnclosureResult::displacement},
+};
+constexpr std::size_t kColumnCount = sizeof(kColumns) / sizeof(kColumns[0]);
+
+struct SensitivityColumn {
+    const char* name;
+    Sensitivity::Row Sensitivity::*member;
+};
+
+constexpr SensitivityColumn kSensitivityColumns[] = {
+    {"vb", &Sensitivity::vb},
+    {"fc_or_fb", &Sensitivity::fc_or_fb},
+    {"port_length", &Sensitivity::port_length},
+    {"width", &Sensitivity::width},
+    {"height", &Sensitivity::height},
+    {"depth", &Sensitivity::depth},
+};
+constexpr std::size_t kSensitivityCount = sizeof(kSensitivityColumns) / sizeof(kSensitivityColumns[0]) * kParameterCount;
+
+// TSParameters fields in Gradient order, named as in config files
+constexpr const char* kParameterKeys[kParameterCount] = {"fs", "qts", "vas", "re", "sd", "xmax", "vd", "le", "cms", "mms", "bl"};
+
+std::string sensitivityName(const SensitivityColumn& column, std::size_t param) {
+    return std::string("d") + column.name + "_d" + kParameterKeys[param];
+}
+
+void appendNumber(std::string& out, double value) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, res.ptr);
+}
+
+template <typename T>
+void appendRaw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));  // Little-endian hosts
+}
+
+unsigned char typeCode(const std::string& type) {
+    if (type == "Sealed") return static_cast<unsigned char>(EnclosureType::Sealed);
+    if (type == "Ported") return static_cast<unsigned char>(EnclosureType::Ported);
+    if (type == "Bandpass") return static_cast<unsigned char>(EnclosureType::Bandpass);
+    if (type == "TransmissionLine") return static_cast<unsigned char>(EnclosureType::TransmissionLine);
+    if (type == "PassiveRadiator") return static_cast<unsigned char>(EnclosureType::PassiveRadiator);
+    return 255;
+}
+
+std::string joinWarnings(const std::vector<std::string>& warnings) {
+    std::string out;
+    for (const auto& w : warnings) {
+        if (!out.empty()) out += "; ";
+        out += w;
+    }
+    return out;
+}
+
+void appendJsonString(std::string& out, const std::string& str) {
+    out += '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+}  // namespace
+
+BlockWriter::BlockWriter(const std::string& file, std::size_t block_size, bool compress)
+    : file_(nullptr), gz_(nullptr), ok_(false), compress_(false), block_size_(block_size), active_(0), pending_(false), stop_(false) {
+#ifdef SPEAKERBOX_HAVE_ZLIB
+    if (compress) {
+        gz_ = gzopen(file.c_str(), "wb6");
+        compress_ = gz_ != nullptr;
+        ok_ = compress_;
+    }
+#else
+    (void)compress;
+#endif
+    if (!gz_) {
+        file_ = std::fopen(file.c_str(), "wb");
+        ok_ = file_ != nullptr;
+    }
+    if (!ok_) return;
+    buffers_[0].reserve(block_size_);
+    buffers_[1].reserve(block_size_);
+    thread_ = std::thread(&BlockWriter::run, this);
+}
+
+BlockWriter::~BlockWriter() {
+    close();
+}
+
+void BlockWriter::write(const void* data, std::size_t size) {
+    block().append(static_cast<const char*>(data), size);
+    commit();
+}
+
+void BlockWriter::commit() {
+    if (block().size() >= block_size_) swap();
+}
+
+void BlockWriter::flush() {
+    if (!thread_.joinable()) return;
+    if (!block().empty()) swap();
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !pending_; });
+    if (file_) std::fflush(file_);
+}
+
+void BlockWriter::close() {
+    if (!thread_.joinable()) return;
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    if (file_ && std::fclose(file_) != 0) ok_ = false;
+#ifdef SPEAKERBOX_HAVE_ZLIB
+    if (gz_ && gzclose(static_cast<gzFile>(gz_)) != Z_OK) ok_ = false;
+#endif
+    file_ = nullptr;
+    gz_ = nullptr;
+}
+
+void BlockWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return pending_ || stop_; });
+        if (!pending_) break;
+        std::string& buf = buffers_[active_ ^ 1];
+        lock.unlock();
+        bool written;
+#ifdef SPEAKERBOX_HAVE_ZLIB
+        if (gz_) written = gzwrite(static_cast<gzFile>(gz_), buf.data(), static_cast<unsigned>(buf.size())) == static_cast<int>(buf.size());
+        else
+#endif
+        written = std::fwrite(buf.data(), 1, buf.size(), file_) == buf.size();
+        if (!written) ok_ = false;
+        buf.clear();
+        lock.lock();
+        pending_ = false;
+        cv_.notify_all();
+    }
+}
+
+void BlockWriter::swap() {
+    if (!thread_.joinable()) {  // Never opened, or closed: nothing would ever take the block
+        block().clear();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !pending_; });
+    active_ ^= 1;
+    pending_ = true;
+    cv_.notify_all();
+}
+
+ExportFormat exportFormatFromPath(const std::string& file) {
+    std::string name = file;
+    if (name.size() > 3 && name.compare(name.size() - 3, 3, ".gz") == 0) name.resize(name.size() - 3);
+    auto ends = [&](const std::string& ext) {
+        return name.size() >= ext.size() && name.compare(name.size() - ext.size(), ext.size(), ext) == 0;
+    };
+    if (ends(".jsonl")) return ExportFormat::JsonLines;
+    if (ends(".sbxc")) return ExportFormat::Columnar;
+    return ExportFormat::Csv;
+}
+
+ResultExporter::ResultExporter(const std::string& file, ExportFormat format, bool compress, bool sensitivities)
+    : writer_(file, 1 << 20, compress), format_(format), sensitivities_(sensitivities), rows_(0), closed_(false) {
+    if (format_ == ExportFormat::Columnar) {
+        f64_columns_.resize(kColumnCount + (sensitivities_ ? kSensitivityCount : 0));
+        for (auto& column : f64_columns_) column.reserve(kColumnarRows);
+        type_column_.reserve(kColumnarRows);
+        xmax_column_.reserve(kColumnarRows);
+        warning_offsets_.reserve(kColumnarRows + 1);
+        warning_offsets_.push_back(0);
+    }
+    if (writer_.ok()) writeHeader();
+}
+
+ResultExporter::~ResultExporter() {
+    close();
+}
+
+void ResultExporter::write(const std::vector<EnclosureResult>& batch, const std::vector<Sensitivity>* sensitivities) {
+    if (closed_) return;
+    const Sensitivity none{};
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        const EnclosureResult& result = batch[i];
+        const Sensitivity& sensitivity = sensitivities && i < sensitivities->size() ? (*sensitivities)[i] : none;
+        switch (format_) {
+            case ExportFormat::Csv: writeCsv(result, sensitivity); break;
+            case ExportFormat::JsonLines: writeJson(result, sensitivity); break;
+            case ExportFormat::Columnar: appendColumnar(result, sensitivity); break;
+        }
+        if (format_ != ExportFormat::Columnar) writer_.commit();
+    }
+    rows_ += batch.size();
+}
+
+void ResultExporter::close() {
+    if (closed_) return;
+    closed_ = true;
+    if (format_ == ExportFormat::Columnar) {
+        if (type_column_.size() > 0) flushColumnar();
+        appendRaw<std::uint32_t>(writer_.block(), 0);
+    }
+    writer_.close();
+}
+
+void ResultExporter::writeHeader() {
+    std::string& out = writer_.block();
+    switch (format_) {
+        case ExportFormat::Csv:
+            out += "type";
+            for (const auto& column : kColumns) {
+                out += ',';
+                out += column.name;
+            }
+            if (sensitivities_) {
+                for (const auto& column : kSensitivityColumns) {
+                    for (std::size_t p = 0; p < kParameterCount; ++p) out += ',' + sensitivityName(column, p);
+                }
+            }
+            out += ",within_xmax,warnings\n";
+            break;
+        case ExportFormat::JsonLines:
+            break;
+        case ExportFormat::Columnar: {
+            out += "SBXC";
+            appendRaw<std::uint32_t>(out, 1);
+            appendRaw<std::uint32_t>(out, static_cast<std::uint32_t>(f64_columns_.size() + 3));
+            auto column = [&](unsigned char kind, const std::string& name) {
+                appendRaw<unsigned char>(out, kind);
+                appendRaw<std::uint16_t>(out, static_cast<std::uint16_t>(name.size()));
+                out += name;
+            };
+            column(1, "type");
+            for (const auto& c : kColumns) column(0, c.name);
+            if (sensitivities_) {
+                for (const auto& c : kSensitivityColumns) {
+                    for (std::size_t p = 0; p < kParameterCount; ++p) column(0, sensitivityName(c, p));
+                }
+            }
+            column(1, "within_xmax");
+            column(2, "warnings");
+            break;
+        }
+    }
+}
+
+void ResultExporter::writeCsv(const EnclosureResult& result, const Sensitivity& sensitivity) {
+    std::string& out = writer_.block();
+    out += result.type;
+    for (const auto& column : kColumns) {
+        out += ',';
+        appendNumber(out, result.*column.member);
+    }
+    if (sensitivities_) {
+        for (const auto& column : kSensitivityColumns) {
+            for (double d : sensitivity.*column.member) {
+                out += ',';
+                appendNumber(out, d);
+            }
+        }
+    }
+    out += result.within_xmax ? ",1," : ",0,";
+    if (!result.warnings.empty()) {
+        out += '"';
+        for (char c : joinWarnings(result.warnings)) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        out += '"';
+    }
+    out += '\n';
+}
+
+void ResultExporter::writeJson(const EnclosureResult& result, const Sensitivity& sensitivity) {
+    std::string& out = writer_.block();
+    out += "{\"type\":";
+    appendJsonString(out, result.type);
+    for (const auto& column : kColumns) {
+        out += ",\"";
+        out += column.name;
+        out += "\":";
+        double value = result.*column.member;
+        if (std::isfinite(value)) appendNumber(out, value);
+        else out += "null";
+    }
+    if (sensitivities_) {
+        out += ",\"sensitivity\":{";
+        for (std::size_t c = 0; c < sizeof(kSensitivityColumns) / sizeof(kSensitivityColumns[0]); ++c) {
+            out += c ? ",\"" : "\"";
+            out += kSensitivityColumns[c].name;
+            out += "\":{";
+            const Sensitivity::Row& row = sensitivity.*kSensitivityColumns[c].member;
+            for (std::size_t p = 0; p < kParameterCount; ++p) {
+                out += p ? ",\"" : "\"";
+                out += kParameterKeys[p];
+                out += "\":";
+                if (std::isfinite(row[p])) appendNumber(out, row[p]);
+                else out += "null";
+            }
+            out += '}';
+        }
+        out += '}';
+    }
+    out += result.within_xmax ? ",\"within_xmax\":true" : ",\"within_xmax\":false";
+    out += ",\"warnings\":[";
+    for (std::size_t i = 0; i < result.warnings.size(); ++i) {
+        if (i) out += ',';
+        appendJsonString(out, result.warnings[i]);
+    }
+    out += "]}\n";
+}
+
+void ResultExporter::appendColumnar(const EnclosureResult& result, const Sensitivity& sensitivity) {
+    type_column_.push_back(typeCode(result.type));
+    for (std::size_t c = 0; c < kColumnCount; ++c) f64_columns_[c].push_back(result.*kColumns[c].member);
+    if (sensitivities_) {
+        std::size_t c = kColumnCount;
+        for (const auto& column : kSensitivityColumns) {
+            for (double d : sensitivity.*column.member) f64_columns_[c++].push_back(d);
+        }
+    }
+    xmax_column_.push_back(result.within_xmax ? 1 : 0);
+    warning_bytes_ += joinWarnings(result.warnings);
+    warning_offsets_.push_back(static_cast<std::uint32_t>(warning_bytes_.size()));
+    if (type_column_.size() == kColumnarRows) flushColumnar();
+}
+
+void ResultExporter::flushColumnar() {
+    std::uint32_t count = static_cast<std::uint32_t>(type_column_.size());
+    writer_.write(&count, sizeof(count));
+    writer_.write(type_column_.data(), type_column_.size());
+    for (auto& column : f64_columns_) {
+        writer_.write(column.data(), column.size() * sizeof(double));
+        column.clear();
+    }
+    writer_.write(xmax_column_.data(), xmax_column_.size());
+    writer_.write(warning_offsets_.data(), warning_offsets_.size() * sizeof(std::uint32_t));
+    writer_.write(warning_bytes_.data(), warning_bytes_.size());
+    type_column_.clear();
+    xmax_column_.clear();
+    warning_offsets_.assign(1, 0);
+    warning_bytes_.clear();
+}
+
+}  // namespace speakerbox
@@ -0,0 +1,177 @@
+#include "fft.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace speakerbox {
+
+namespace {
+
+using Complex = std::complex<double>;
+
+// Plain product; operator* carries NaN recovery that keeps loops from vectorizing
+inline Complex mul(Complex a, Complex b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+inline Complex mulNegI(Complex a) {
+    return {a.imag(), -a.real()};
+}
+
+Complex root(double turns) {
+    return std::polar(1.0, -2.0 * PI * turns);
+}
+
+// Stockham decimation-in-frequency butterflies. Sub-transform q of the input
+// holds x[q + s * (k + a * m)]; output lands at y[q + s * (p * k + b)], times
+// exp(-2 pi i k b / (p * m)). The inner q loop is unit-stride and lengthens
+// by the radix each pass, so all but the first passes vectorize.
+template <typename Butterfly>
+void stockhamPass(std::size_t s, std::size_t m, Butterfly butterfly) {
+    for (std::size_t k = 0; k < m; ++k) {
+        for (std::size_t q = 0; q < s; ++q) butterfly(q, k);
+    }
+}
+
+void radix2(const Complex* x, Complex* y, std::size_t s, std::size_t m, const Complex* w) {
+    stockhamPass(s, m, [=](std::size_t q, std::size_t k) {
+        Complex c0 = x[q + s * k], c1 = x[q + s * (k + m)];
+        y[q + s * 2 * k] = c0 + c1;
+        y[q + s * (2 * k + 1)] = mul(c0 - c1, w[k]);
+    });
+}
+
+void radix3(const Complex* x, Complex* y, std::size_t s, std::size_t m, const Complex* w) {
+    const double sin60 = std::sqrt(3.0) / 2.0;
+    stockhamPass(s, m, [=](std::size_t q, std::size_t k) {
+        Complex c0 = x[q + s * k], c1 = x[q + s * (k + m)], c2 = x[q + s * (k + 2 * m)];
+        Complex t = c1 + c2;
+        Complex mid = c0 - 0.5 * t;
+        Complex u = sin60 * mulNegI(c1 - c2);
+        y[q + s * 3 * k] = c0 + t;
+        y[q + s * (3 * k + 1)] = mul(mid + u, w[2 * k]);
+        y[q + s * (3 * k + 2)] = mul(mid - u, w[2 * k + 1]);
+    });
+}
+
+void radix4(const Complex* x, Complex* y, std::size_t s, std::size_t m, const Complex* w) {
+    stockhamPass(s, m, [=](std::size_t q, std::size_t k) {
+        Complex c0 = x[q + s * k], c1 = x[q + s * (k + m)], c2 = x[q + s * (k + 2 * m)], c3 = x[q + s * (k + 3 * m)];
+        Complex e0 = c0 + c2, e1 = c0 - c2;
+        Complex o0 = c1 + c3, o1 = mulNegI(c1 - c3);
+        y[q + s * 4 * k] = e0 + o0;
+        y[q + s * (4 * k + 1)] = mul(e1 + o1, w[3 * k]);
+        y[q + s * (4 * k + 2)] = mul(e0 - o0, w[3 * k + 1]);
+        y[q + s * (4 * k + 3)] = mul(e1 - o1, w[3 * k + 2]);
+    });
+}
+
+void radixGeneric(const Complex* x, Complex* y, std::size_t p, std::size_t s, std::size_t m, const Complex* w, const Complex* roots) {
+    for (std::size_t k = 0; k < m; ++k) {
+        const Complex* a = x + s * k;
+        Complex* out = y + s * p * k;
+        for (std::size_t b = 0; b < p; ++b) {
+            const Complex wb = b ? w[(p - 1) * k + b - 1] : Complex(1.0, 0.0);
+            for (std::size_t q = 0; q < s; ++q) {
+                Complex acc = a[q];
+                for (std::size_t j = 1; j < p; ++j) acc += mul(a[q + j * s * m], roots[(j * b) % p]);
+                out[q + b * s] = mul(acc, wb);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+FftPlan::FftPlan(std::size_t n) : n_(std::max<std::size_t>(2, n + (n & 1))) {
+    // Factor the half length, radix 4 first since it needs the fewest multiplies
+    std::size_t half = n_ / 2;
+    std::vector<std::size_t> factors;
+    while (half % 4 == 0) {
+        factors.push_back(4);
+        half /= 4;
+    }
+    for (std::size_t p = 2; half > 1; ++p) {
+        while (half % p == 0) {
+            factors.push_back(p);
+            half /= p;
+        }
+    }
+
+    std::size_t span = n_ / 2, stride = 1;
+    for (std::size_t p : factors) {
+        Stage stage{p, span, stride, twiddles_.size(), roots_.size()};
+        std::size_t m = span / p;
+        for (std::size_t k = 0; k < m; ++k) {
+            for (std::size_t b = 1; b < p; ++b) twiddles_.push_back(root(static_cast<double>(k * b) / span));
+        }
+        if (p >= 5) {
+            for (std::size_t j = 0; j < p; ++j) roots_.push_back(root(static_cast<double>(j) / p));
+        }
+        stages_.push_back(stage);
+        span = m;
+        stride *= p;
+    }
+
+    real_twiddles_.resize(n_ / 2 + 1);
+    for (std::size_t k = 0; k <= n_ / 2; ++k) real_twiddles_[k] = root(static_cast<double>(k) / n_);
+}
+
+std::shared_ptr<const FftPlan> FftPlan::get(std::size_t n) {
+    // Only lookups lock; transforms on the returned plan never do
+    static std::mutex mutex;
+    static std::map<std::size_t, std::shared_ptr<const FftPlan>> plans;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& plan = plans[n];
+    if (!plan) plan = std::make_shared<const FftPlan>(n);
+    return plan;
+}
+
+std::complex<double>* FftPlan::transform(std::complex<double>* x, std::complex<double>* y) const {
+    for (const Stage& stage : stages_) {
+        std::size_t m = stage.span / stage.radix;
+        const Complex* w = twiddles_.data() + stage.twiddle;
+        switch (stage.radix) {
+            case 2: radix2(x, y, stage.stride, m, w); break;
+            case 3: radix3(x, y, stage.stride, m, w); break;
+            case 4: radix4(x, y, stage.stride, m, w); break;
+            default: radixGeneric(x, y, stage.radix, stage.stride, m, w, roots_.data() + stage.roots); break;
+        }
+        std::swap(x, y);
+    }
+    return x;
+}
+
+void FftPlan::forward(const double* in, std::complex<double>* out, std::complex<double>* work) const {
+    // Pack even / odd samples as one complex sequence of half the length
+    const std::size_t half = n_ / 2;
+    for (std::size_t j = 0; j < half; ++j) work[j] = Complex(in[2 * j], in[2 * j + 1]);
+    const Complex* z = transform(work, work + half);
+    for (std::size_t k = 0; k <= half; ++k) {
+        Complex zk = z[k < half ? k : 0], zc = std::conj(z[k ? half - k : 0]);
+        Complex even = 0.5 * (zk + zc);
+        Complex odd = 0.5 * mulNegI(zk - zc);
+        out[k] = even + mul(odd, real_twiddles_[k]);
+    }
+}
+
+void FftPlan::inverse(const std::complex<double>* in, double* out, std::complex<double>* work) const {
+    // Undo the even / odd split, then invert via conj(FFT(conj(Z)))
+    const std::size_t half = n_ / 2;
+    for (std::size_t k = 0; k < half; ++k) {
+        Complex xc = std::conj(in[half - k]);
+        Complex even = 0.5 * (in[k] + xc);
+        Complex odd = 0.5 * mul(in[k] - xc, std::conj(real_twiddles_[k]));
+        work[k] = std::conj(even + Complex(-odd.imag(), odd.real()));
+    }
+    const Complex* z = transform(work, work + half);
+    const double scale = 1.0 / half;
+    for (std::size_t j = 0; j < half; ++j) {
+        out[2 * j] = z[j].real() * scale;
+        out[2 * j + 1] = -z[j].imag() * scale;
+    }
+}
+
+}  // namespace speakerbox
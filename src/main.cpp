@@ -1,23 +1,380 @@
 #include "ui.h"
 #include "calculator.h"
 #include "config.h"
+#include "model.h"
+#include "export.h"
+#include "simulator.h"
+#include "transient.h"
+#include "render.h"
+#include "crossover.h"
+#include "directivity.h"
+#include "cutlist.h"
 #include "utils.h"
 #include <iostream>
 #include <string>
 #include <map>
 #include <vector>
 #include <filesystem>
+#include <fstream>
 #include <glog/logging.h>
 #include <atomic>
 #include <thread>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <algorithm>
 #include <getopt.h>
 
 namespace speakerbox {
 
+constexpr std::size_t kBatchRows = 65536;  // Parameter rows in flight per batch step
+
+bool parseEnclosureType(const std::string& name, EnclosureType& type) {
+    static const std::map<std::string, EnclosureType> types = {
+        {"sealed", EnclosureType::Sealed}, {"ported", EnclosureType::Ported},
+        {"bandpass", EnclosureType::Bandpass}, {"tl", EnclosureType::TransmissionLine},
+        {"pr", EnclosureType::PassiveRadiator}
+    };
+    auto it = types.find(name);
+    if (it == types.end()) return false;
+    type = it->second;
+    return true;
+}
+
+// kind:order:frequency[:level], e.g. lowpass:4:2500:-2
+bool parseCrossoverTarget(const std::string& spec, CrossoverTarget& target) {
+    std::vector<std::string> fields;
+    std::size_t start = 0;
+    for (std::size_t pos; (pos = spec.find(':', start)) != std::string::npos; start = pos + 1) fields.push_back(spec.substr(start, pos - start));
+    fields.push_back(spec.substr(start));
+    if (fields.size() < 3 || fields.size() > 4) return false;
+    if (fields[0] == "lowpass" || fields[0] == "lp") target.kind = FilterKind::LowPass;
+    else if (fields[0] == "highpass" || fields[0] == "hp") target.kind = FilterKind::HighPass;
+    else return false;
+    target.order = std::atoi(fields[1].c_str());
+    target.frequency = std::atof(fields[2].c_str());
+    target.level = fields.size() > 3 ? std::atof(fields[3].c_str()) : 0.0;
+    target.zobel = target.kind == FilterKind::LowPass;  // Only a woofer's Le matters at its crossover
+    return target.order >= 1 && target.order <= 4 && target.frequency > 0.0 && target.level <= 0.0;
+}
+
+// Build settings (panel, braces, cutout, size limits) from an optional config file
+std::map<std::string, double> loadCabinetOptions(const std::string& file) {
+    Config config;
+    std::map<std::string, double> options;
+    if (config.load(file)) config.loadCabinetOptions(options);
+    return options;
+}
+
+int runBatch(const std::string& input, const std::string& output, const std::string& params_file, EnclosureType type, bool compress,
+             bool sensitivity) {
+    std::ifstream in(input);
+    TSParametersReader reader(in);
+    if (!in || !reader.ok()) {
+        std::cerr << "Error: cannot read parameters from " << input << std::endl;
+        return 1;
+    }
+    ResultExporter exporter(output, exportFormatFromPath(output), compress, sensitivity);
+    if (!exporter.ok()) {
+        std::cerr << "Error: cannot write " << output << std::endl;
+        return 1;
+    }
+    if (compress && !exporter.compressed()) std::cerr << "Warning: built without zlib, writing uncompressed" << std::endl;
+
+    // One chunk of rows in flight; the exporter writes the previous block in the background
+    Calculator calc;
+    const std::map<std::string, double> options = loadCabinetOptions(params_file);
+    std::vector<TSParameters> rows;
+    std::vector<Sensitivity> sensitivities;
+    while (reader.read(rows, kBatchRows) > 0) {
+        std::vector<Sensitivity>* out = sensitivity ? &sensitivities : nullptr;
+        exporter.write(calc.calculateBatch(rows, type, options, out), out);
+    }
+    exporter.close();
+    LOG(INFO) << "Batch: " << exporter.rows() << " rows to " << output;
+    return exporter.ok() ? 0 : 1;
+}
+
+bool loadParameters(const std::string& file, TSParameters& params) {
+    Config config;
+    if (!config.load(file)) {
+        std::cerr << "Error: cannot read " << file << std::endl;
+        return false;
+    }
+    config.loadTSParameters(params);
+    return true;
+}
+
+int runSimulation(const std::string& file, EnclosureType type) {
+    TSParameters params;
+    if (!loadParameters(file, params)) return 1;
+    Calculator calc;
+    EnclosureResult result = calc.calculate(params, type);
+    Simulator sim(params, result);
+    if (!sim.ok()) {
+        std::cerr << "Error: simulation needs fs, qts, re, sd and a valid box" << std::endl;
+        return 1;
+    }
+
+    // Third-octave sweep at four drive levels, then SMPTE intermodulation
+    std::vector<double> freqs = {20, 25, 31.5, 40, 50, 63, 80, 100, 125, 160, 200};
+    std::vector<double> levels = {1.0, 2.83, 10.0, 30.0};
+    std::vector<DistortionTest> tests = Simulator::sweep(freqs, levels);
+    for (double v : levels) tests.push_back({60.0, v, 400.0});
+    std::vector<DistortionResult> res = sim.run(tests);
+
+    std::cout << result.type << " Vb=" << result.vb << " L Fc/Fb=" << result.fc_or_fb << " Hz" << std::endl;
+    std::cout << "f(Hz)\tV\tSPL(dB)\tTHD(%)\tH2(%)\tH3(%)\tIMD(%)\tComp(dB)\tXpk(mm)" << std::endl;
+    for (std::size_t i = 0; i < tests.size(); ++i) {
+        std::cout << tests[i].frequency << (tests[i].frequency2 > 0.0 ? "+" + std::to_string(static_cast<int>(tests[i].frequency2)) : "")
+                  << "\t" << tests[i].voltage << "\t" << res[i].spl << "\t" << res[i].thd << "\t" << res[i].h2 << "\t" << res[i].h3
+                  << "\t" << res[i].imd << "\t" << res[i].compression << "\t" << res[i].peak_excursion << std::endl;
+    }
+    return 0;
+}
+
+int runTransient(const std::string& file) {
+    TSParameters params;
+    if (!loadParameters(file, params)) return 1;
+    // Every enclosure type side by side
+    Calculator calc;
+    std::vector<EnclosureResult> results;
+    for (int t = 0; t <= static_cast<int>(EnclosureType::PassiveRadiator); ++t) {
+        results.push_back(calc.calculate(params, static_cast<EnclosureType>(t)));
+    }
+    TransientAnalyzer analyzer;
+    std::vector<TransientMetrics> metrics = analyzer.analyzeBatch(calc, std::vector<TSParameters>(results.size(), params), results);
+
+    std::cout << "Type\tFc/Fb(Hz)\tGD@Fc(ms)\tPeakGD(ms)\tat(Hz)\tUndershoot(%)\tDecay(ms)" << std::endl;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        std::cout << results[i].type << "\t" << results[i].fc_or_fb << "\t" << metrics[i].group_delay_at_tuning << "\t"
+                  << metrics[i].peak_group_delay << "\t" << metrics[i].peak_group_delay_freq << "\t" << metrics[i].step_undershoot
+                  << "\t" << metrics[i].decay_time << std::endl;
+    }
+    return 0;
+}
+
+int runPolar(const std::string& file, EnclosureType type) {
+    TSParameters params;
+    if (!loadParameters(file, params)) return 1;
+    Calculator calc;
+    EnclosureResult result = calc.calculate(params, type, loadCabinetOptions(file));  // The baffle is built as the file says
+    DirectivityModel model;
+    auto start = std::chrono::steady_clock::now();
+    PolarMap map = model.compute(params, result);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (map.spl.empty()) {
+        std::cerr << "Error: directivity needs sd and a box for " << result.type << std::endl;
+        return 1;
+    }
+    DirectivityMetrics metrics = model.metrics(map);
+
+    // Every 10th frequency, levels relative to the axis
+    const std::size_t angles[] = {0, 15, 30, 45, 60, 90, 120, 150, 180};
+    const double step = 180.0 / (map.angles.size() - 1);
+    std::cout << result.type << " " << result.outer_width << " x " << result.outer_height << " cm baffle, " << map.freqs.size() << " x "
+              << map.angles.size() << " map in " << elapsed * 1e3 << " ms" << std::endl;
+    std::cout << "f(Hz)\tAxis(dB)\tDI(dB)";
+    for (std::size_t a = 1; a < sizeof(angles) / sizeof(angles[0]); ++a) std::cout << "\t" << angles[a];
+    std::cout << std::endl;
+    for (std::size_t i = 0; i < map.freqs.size(); i += 10) {
+        std::cout << map.freqs[i] << "\t" << map.at(i, 0) << "\t" << map.di[i];
+        for (std::size_t a = 1; a < sizeof(angles) / sizeof(angles[0]); ++a) {
+            std::size_t j = static_cast<std::size_t>(std::lround(angles[a] / step));
+            std::cout << "\t" << map.at(i, j) - map.at(i, 0);
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "DI 1 kHz " << metrics.di_1k << " dB, 10 kHz " << metrics.di_10k << " dB; beaming (45 deg -6 dB) from " << metrics.beaming_freq
+              << " Hz; on-axis span " << metrics.on_axis_span << " dB" << std::endl;
+    return 0;
+}
+
+int runDirectivity(const std::string& input, const std::string& output, const std::string& params_file, EnclosureType type) {
+    std::ifstream in(input);
+    TSParametersReader reader(in);
+    if (!in || !reader.ok()) {
+        std::cerr << "Error: cannot read parameters from " << input << std::endl;
+        return 1;
+    }
+    BlockWriter writer(output);
+    if (!writer.ok()) {
+        std::cerr << "Error: cannot write " << output << std::endl;
+        return 1;
+    }
+    writer.block() += "type,vb,outer_width,outer_height,di_1k,di_10k,beaming_freq,on_axis_span\n";
+
+    Calculator calc;
+    const std::map<std::string, double> options = loadCabinetOptions(params_file);
+    DirectivityModel model;
+    std::vector<TSParameters> rows;
+    std::size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (reader.read(rows, kBatchRows) > 0) {
+        std::vector<EnclosureResult> results = calc.calculateBatch(rows, type, options);
+        std::vector<DirectivityMetrics> metrics = model.analyzeBatch(rows, results);
+        char line[160];
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            std::snprintf(line, sizeof(line), ",%.9g,%.9g,%.9g,%.6g,%.6g,%.6g,%.6g\n", results[i].vb, results[i].outer_width, results[i].outer_height,
+                          metrics[i].di_1k, metrics[i].di_10k, metrics[i].beaming_freq, metrics[i].on_axis_span);
+            writer.block() += results[i].type;
+            writer.block() += line;
+            writer.commit();
+        }
+        total += rows.size();
+    }
+    writer.close();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOG(INFO) << "Directivity: " << total << " designs to " << output << " in " << elapsed << " s";
+    return writer.ok() ? 0 : 1;
+}
+
+int runCutList(const std::string& input, const std::string& params_file, EnclosureType type) {
+    std::ifstream in(input);
+    TSParametersReader reader(in);
+    if (!in || !reader.ok()) {
+        std::cerr << "Error: cannot read parameters from " << input << std::endl;
+        return 1;
+    }
+    // Build settings are optional: panel, braces and size limits, then the sheet stock
+    Config config;
+    config.load(params_file);
+    std::map<std::string, double> options;
+    config.loadCabinetOptions(options);
+    CabinetConstraints constraints = CabinetConstraints::fromOptions(options);
+    CutListOptions sheet;
+    sheet.sheet_width = std::stod(config.get("sheet_width", std::to_string(sheet.sheet_width)));
+    sheet.sheet_height = std::stod(config.get("sheet_height", std::to_string(sheet.sheet_height)));
+    sheet.kerf = std::stod(config.get("kerf", std::to_string(sheet.kerf)));
+    sheet.trim = std::stod(config.get("trim", std::to_string(sheet.trim)));
+    sheet.workers = static_cast<std::size_t>(std::max(std::stod(config.get("workers", "0")), 0.0));
+
+    Calculator calc;
+    std::vector<TSParameters> rows;
+    std::vector<Panel> panels;
+    std::size_t cabinets = 0, oversize = 0;
+    while (reader.read(rows, kBatchRows) > 0) {
+        for (const EnclosureResult& result : calc.calculateBatch(rows, type, options)) {
+            std::vector<Panel> box = cabinetPanels(result, constraints, cabinets++);
+            panels.insert(panels.end(), box.begin(), box.end());
+            oversize += std::any_of(result.warnings.begin(), result.warnings.end(),
+                                    [](const std::string& w) { return w == kOversizeWarning || w == kCutoutWarning; });
+        }
+    }
+    if (panels.empty()) {
+        std::cerr << "Error: no " << input << " row gives a box" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CutList list = CutListOptimizer(sheet).optimize(panels);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << cabinets << " cabinets, " << panels.size() << " panels on " << list.sheets << " sheets of " << sheet.sheet_width << " x "
+              << sheet.sheet_height << " mm, waste " << list.waste * 100.0 << " %, emptiest sheet " << list.smallest_fill * 100.0 << " % used; "
+              << sheet.attempts << " packings in " << elapsed << " s" << std::endl;
+    if (oversize) std::cout << "Warning: " << oversize << " cabinets exceed the maximum size" << std::endl;
+    for (std::size_t p : list.unplaced) {
+        std::cout << "Warning: cabinet " << panels[p].cabinet << " " << panels[p].name << " " << panels[p].width << " x " << panels[p].height
+                  << " mm does not fit a sheet" << std::endl;
+    }
+    std::cout << "Sheet\tCabinet\tPanel\tW(mm)\tH(mm)\tX(mm)\tY(mm)\tRotated" << std::endl;
+    for (const Placement& place : list.placements) {
+        const Panel& panel = panels[place.panel];
+        std::cout << place.sheet << "\t" << panel.cabinet << "\t" << panel.name << "\t" << panel.width << "\t" << panel.height << "\t" << place.x
+                  << "\t" << place.y << "\t" << (place.rotated ? "yes" : "no") << std::endl;
+    }
+    return 0;
+}
+
+int runCrossover(const std::string& spec, const std::string& params_file, EnclosureType type) {
+    CrossoverTarget target;
+    if (!parseCrossoverTarget(spec, target)) {
+        std::cerr << "Error: crossover spec is lowpass|highpass:order(1-4):Hz[:level dB <= 0]" << std::endl;
+        return 1;
+    }
+    TSParameters params;
+    if (!loadParameters(params_file, params)) return 1;
+    Calculator calc;
+    EnclosureResult result = calc.calculate(params, type);
+    Crossover crossover(params, result);
+    if (!crossover.ok()) {
+        std::cerr << "Error: crossover needs fs, qts, re and sd" << std::endl;
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    CrossoverOptimization opt = crossover.optimize(target);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const bool low = target.kind == FilterKind::LowPass;
+    std::cout << result.type << " Vb=" << result.vb << " L Fc/Fb=" << result.fc_or_fb << " Hz; " << (target.order % 2 ? "Butterworth " : "Linkwitz-Riley ")
+              << target.order << (low ? " low-pass " : " high-pass ") << target.frequency << " Hz, " << target.level << " dB" << std::endl;
+    std::cout << "Part\tNominal\tFitted" << std::endl;
+    for (std::size_t e = 0; e < opt.design.ladder.size(); ++e) {
+        bool inductor = (e % 2 == 0) == low;
+        double scale = inductor ? 1e3 : 1e6;
+        std::cout << (inductor ? "L" : "C") << e + 1 << (inductor ? "(mH)" : "(uF)") << "\t" << opt.nominal.ladder[e] * scale << "\t"
+                  << opt.design.ladder[e] * scale << std::endl;
+    }
+    if (opt.design.pad_series > 0.0) {
+        std::cout << "Rs(ohm)\t" << opt.nominal.pad_series << "\t" << opt.design.pad_series << std::endl;
+        std::cout << "Rp(ohm)\t" << opt.nominal.pad_shunt << "\t" << opt.design.pad_shunt << std::endl;
+    }
+    if (opt.design.zobel_r > 0.0) {
+        std::cout << "Rz(ohm)\t" << opt.nominal.zobel_r << "\t" << opt.design.zobel_r << std::endl;
+        std::cout << "Cz(uF)\t" << opt.nominal.zobel_c * 1e6 << "\t" << opt.design.zobel_c * 1e6 << std::endl;
+    }
+    std::cout << "Error(dB rms)\t" << opt.nominal_error << "\t" << opt.error << std::endl;
+    std::cout << opt.evaluations << " candidates in " << elapsed * 1e3 << " ms" << std::endl;
+
+    CrossoverResponse response = crossover.simulate(opt.design);
+    std::vector<double> wanted = crossover.targetCurve(target);
+    std::cout << "Min impedance " << response.min_impedance << " ohm at " << response.min_impedance_freq << " Hz" << std::endl;
+    std::cout << "f(Hz)\tSPL(dB)\tTarget(dB)\tPhase(deg)\t|Z|(ohm)" << std::endl;
+    const std::vector<double>& freqs = crossover.freqs();
+    for (std::size_t k = 0; k < freqs.size(); k += 10) {
+        std::cout << freqs[k] << "\t" << response.spl[k] << "\t" << wanted[k] << "\t" << response.phase[k] << "\t" << response.impedance[k] << std::endl;
+    }
+    return 0;
+}
+
+int runRender(const std::string& input, const std::string& output, const std::string& params_file, EnclosureType type, double drive) {
+    TSParameters params;
+    if (!loadParameters(params_file, params)) return 1;
+    Calculator calc;
+    EnclosureResult result = calc.calculate(params, type);
+    RenderOptions options;
+    options.drive = drive;
+    Renderer renderer(params, result, options);
+    if (!renderer.ok()) {
+        std::cerr << "Error: no response for " << result.type << std::endl;
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    RenderStats stats = renderer.render(input, output);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!stats.ok) {
+        std::cerr << "Error: " << stats.error << std::endl;
+        return 1;
+    }
+    double seconds = stats.frames / stats.sample_rate;
+    std::cout << "Rendered " << seconds << " s, " << stats.channels << " ch through " << result.type << " (Fc/Fb " << result.fc_or_fb
+              << " Hz) in " << elapsed << " s, " << (elapsed > 0.0 ? seconds / elapsed : 0.0) << "x real time" << std::endl;
+    if (stats.clipped) std::cout << "Clipped samples: " << stats.clipped << std::endl;
+    std::cout << "Peak excursion at " << drive << " V: " << stats.peak_excursion << " mm (Xmax " << params.xmax << " mm)" << std::endl;
+    for (const auto& span : stats.over_xmax) std::cout << "  over Xmax " << span.first << " - " << span.second << " s" << std::endl;
+    return 0;
+}
+
 int main(int argc, char** argv) {
     bool use_color = true;
     bool debug = false;
+    std::string batch_file, export_file = "results.csv", simulate_file, transient_file;
+    std::string render_input, render_output, params_file = "data/config.cfg", crossover_spec, polar_file, directivity_file, cutlist_file;
+    double drive = 2.83;
+    EnclosureType batch_type = EnclosureType::Sealed;
+    bool compress = false;
+    bool sensitivity = false;
 
     // Parse flags
     static struct option long_options[] = {
@@ -25,23 +382,87 @@ int main(int argc, char** argv) {
         {"version", no_argument, 0, 'v'},
         {"no-color", no_argument, 0, 'n'},
         {"debug", no_argument, 0, 'd'},
+        {"batch", required_argument, 0, 'b'},
+        {"export", required_argument, 0, 'o'},
+        {"type", required_argument, 0, 't'},
+        {"compress", no_argument, 0, 'z'},
+        {"sensitivity", no_argument, 0, 'e'},
+        {"simulate", required_argument, 0, 's'},
+        {"transient", required_argument, 0, 'i'},
+        {"render", required_argument, 0, 'r'},
+        {"params", required_argument, 0, 'p'},
+        {"drive", required_argument, 0, 'g'},
+        {"crossover", required_argument, 0, 'x'},
+        {"polar", required_argument, 0, 'a'},
+        {"directivity", required_argument, 0, 'y'},
+        {"cutlist", required_argument, 0, 'c'},
         {0, 0, 0, 0}
     };
     int opt;
-    while ((opt = getopt_long(argc, argv, "hvnd", long_options, nullptr)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hvndb:o:t:zes:i:r:p:g:x:a:y:c:", long_options, nullptr)) != -1) {
         switch (opt) {
-            case 'h': std::cout << "Help: speakerbox [options]" << std::endl; return 0;
+            case 'h':
+                std::cout << "Help: speakerbox [options]" << std::endl;
+                std::cout << "  --batch params.csv --export out.{csv,jsonl,sbxc}[.gz] [--params build.cfg] [--type sealed|ported|bandpass|tl|pr] [--compress] [--sensitivity]" << std::endl;
+                std::cout << "  --simulate params.cfg [--type ...]  large-signal distortion sweep" << std::endl;
+                std::cout << "  --transient params.cfg  group delay and step decay of every enclosure type" << std::endl;
+                std::cout << "  --render in.wav out.wav [--params params.cfg] [--type ...] [--drive Vrms]  hear the box" << std::endl;
+                std::cout << "  --crossover lowpass|highpass:order:Hz[:dB] [--params params.cfg] [--type ...]  fit a passive network" << std::endl;
+                std::cout << "  --polar params.cfg [--type ...]  polar map and directivity index" << std::endl;
+                std::cout << "  --directivity params.csv --export out.csv [--params build.cfg] [--type ...]  directivity metrics per design" << std::endl;
+                std::cout << "  --cutlist params.csv [--params build.cfg] [--type ...]  size every box and nest the panels on sheets" << std::endl;
+                return 0;
             case 'v': std::cout << "0.0.1" << std::endl; return 0;
             case 'n': use_color = false; break;
             case 'd': debug = true; break;
+            case 'b': batch_file = optarg; break;
+            case 'o': export_file = optarg; break;
+            case 't':
+                if (!parseEnclosureType(optarg, batch_type)) {
+                    std::cerr << "Unknown type: " << optarg << std::endl;
+                    return 1;
+                }
+                break;
+            case 'z': compress = true; break;
+            case 'e': sensitivity = true; break;
+            case 's': simulate_file = optarg; break;
+            case 'i': transient_file = optarg; break;
+            case 'r': render_input = optarg; break;
+            case 'p': params_file = optarg; break;
+            case 'g': drive = std::atof(optarg); break;
+            case 'x': crossover_spec = optarg; break;
+            case 'a': polar_file = optarg; break;
+            case 'y': directivity_file = optarg; break;
+            case 'c': cutlist_file = optarg; break;
             default: return 1;
         }
     }
+    // getopt_long moves operands behind the options; only --render takes one, its output file
+    if (!render_input.empty() && optind < argc) render_output = argv[optind++];
+    if (optind < argc) {
+        std::cerr << "Unexpected argument: " << argv[optind] << std::endl;
+        return 1;
+    }
 
     initDataDir();
     initLogging();
     LOG(INFO) << "Started at " << getTimestamp();
 
+    if (!batch_file.empty()) return runBatch(batch_file, export_file, params_file, batch_type, compress, sensitivity);
+    if (!simulate_file.empty()) return runSimulation(simulate_file, batch_type);
+    if (!transient_file.empty()) return runTransient(transient_file);
+    if (!polar_file.empty()) return runPolar(polar_file, batch_type);
+    if (!directivity_file.empty()) return runDirectivity(directivity_file, export_file, params_file, batch_type);
+    if (!cutlist_file.empty()) return runCutList(cutlist_file, params_file, batch_type);
+    if (!crossover_spec.empty()) return runCrossover(crossover_spec, params_file, batch_type);
+    if (!render_input.empty()) {
+        if (render_output.empty()) {
+            std::cerr << "Usage: --render in.wav out.wav" << std::endl;
+            return 1;
+        }
+        return runRender(render_input, render_output, params_file, batch_type, drive);
+    }
+
     UI ui(use_color);
     if (!ui.checkTerminalSize()) return 1;
     ui.showSplash();
@@ -72,21 +493,32 @@ int main(int argc, char** argv) {
     app_config.load("data/config.cfg");
 
     while (true) {
-        int menu = ui.showMenu("Main Menu", {"Calculate", "Load Config", "Save Config", "Settings", "Help", "Exit"});
-        if (menu == 5) break;
-        if (menu == 4) ui.showHelp();
-        if (menu == 3) {
+        int menu = ui.showMenu("Main Menu", {"Calculate", "Live Edit", "Load Config", "Save Config", "Settings", "Help", "Exit"});
+        if (menu == 6 || menu < 0) break;
+        if (menu == 5) ui.showHelp();
+        if (menu == 4) {
             // Settings: toggle color, etc.
             use_color = !use_color;
-            ui.use_color_ = use_color;
+            ui.setColor(use_color);
             app_config.set("use_color", use_color ? "true" : "false");
             app_config.save("data/config.cfg");
         }
-        if (menu == 1 || menu == 2) {
+        if (menu == 2 || menu == 3) {
             std::string file = ui.getInput("Config file");
-            if (menu == 1) app_config.load(file);
+            if (menu == 2) app_config.load(file);
             else app_config.save(file);
         }
+        if (menu == 1) {
+            // Edits recompute only the affected nodes, no progress delay
+            TSParameters params;
+            app_config.loadTSParameters(params);
+            DesignModel model(calc, params);
+            std::map<std::string, double> cabinet;
+            app_config.loadCabinetOptions(cabinet);
+            for (const auto& option : cabinet) model.setOption(option.first, option.second);
+            ui.liveEdit(model);
+            app_config.saveTSParameters(model.params());
+        }
         if (menu == 0) {
             TSParameters params;
             // Input params
@@ -103,12 +535,16 @@ int main(int argc, char** argv) {
 
             std::vector<std::string> types = {"Sealed", "Ported", "Bandpass", "Transmission Line", "Passive Radiator"};
             int type_idx = ui.showMenu("Enclosure Type", types);
+            if (type_idx < 0) break;
             EnclosureType type = static_cast<EnclosureType>(type_idx);
 
             ui.showProgress(1000);  // Fake calc time
 
-            EnclosureResult res = calc.calculate(params, type);
-            ui.displayResult(res);
+            Sensitivity sensitivity;
+            std::map<std::string, double> options;
+            app_config.loadCabinetOptions(options);
+            EnclosureResult res = calc.calculateSensitivity(params, type, sensitivity, options);
+            ui.displayResult(res, params, sensitivity);
 
             // Save log
             LOG(INFO) << "Calculation: " << res.type << " Vb=" << res.vb;
@@ -0,0 +1,163 @@
+#include "model.h"
+#include <algorithm>
+
+namespace speakerbox {
+
+DesignModel::DesignModel(Calculator& calc, const TSParameters& params)
+    : calc_(calc), params_(params), type_(EnclosureType::Sealed), result_(), f3_(0.0), dirty_(Tuning | Geometry | Transfer | Response) {
+    setResponseGrid(10.0, 500.0, 256);
+}
+
+void DesignModel::setParameter(Parameter param, double value) {
+    double& f = params_.*member(param);
+    if (f == value) return;
+    f = value;
+    dirty_ |= dependents(param);
+}
+
+void DesignModel::setType(EnclosureType type) {
+    if (type == type_) return;
+    type_ = type;
+    dirty_ |= Tuning;
+}
+
+void DesignModel::setOption(const std::string& key, double value) {
+    auto it = options_.find(key);
+    if (it != options_.end() && it->second == value) return;
+    options_[key] = value;
+    dirty_ |= dependents(key);
+}
+
+void DesignModel::setResponseGrid(double f_min, double f_max, std::size_t points) {
+    freqs_.resize(points);
+    double ratio = points > 1 ? std::pow(f_max / f_min, 1.0 / (points - 1)) : 1.0;
+    double f = f_min;
+    for (auto& freq : freqs_) {
+        freq = f;
+        f *= ratio;
+    }
+    dirty_ |= Response;
+}
+
+unsigned DesignModel::update() {
+    unsigned recomputed = 0;
+    if (dirty_ & Tuning) {
+        computeTuning();
+        recomputed |= Tuning;
+    }
+    if (dirty_ & Geometry) {
+        computeGeometry();
+        recomputed |= Geometry;
+    }
+    if (dirty_ & Transfer) {
+        computeTransfer();
+        recomputed |= Transfer;
+    }
+    if (dirty_ & Response) {
+        computeResponse();
+        recomputed |= Response;
+    }
+    dirty_ = 0;
+    return recomputed;
+}
+
+double DesignModel::parameter(Parameter param) const {
+    return params_.*member(param);
+}
+
+std::string DesignModel::parameterName(Parameter param) {
+    switch (param) {
+        case Parameter::Fs: return "Fs (Hz)";
+        case Parameter::Qts: return "Qts";
+        case Parameter::Vas: return "Vas (L)";
+        case Parameter::Re: return "Re (ohm)";
+        case Parameter::Sd: return "Sd (cm2)";
+        case Parameter::Xmax: return "Xmax (mm)";
+        case Parameter::Vd: return "Vd (L)";
+        case Parameter::Le: return "Le (mH)";
+        case Parameter::Cms: return "Cms (m/N)";
+        case Parameter::Mms: return "Mms (g)";
+        case Parameter::Bl: return "Bl (Tm)";
+    }
+    return "";
+}
+
+unsigned DesignModel::dependents(Parameter param) {
+    switch (param) {
+        case Parameter::Fs:
+        case Parameter::Qts:
+            return Tuning | Transfer;
+        case Parameter::Vas:
+            return Tuning;
+        case Parameter::Sd:
+        case Parameter::Xmax:
+        case Parameter::Vd:
+            return Geometry;
+        default:
+            return 0;  // Electrical parameters feed no node yet
+    }
+}
+
+unsigned DesignModel::dependents(const std::string& option) {
+    const std::vector<std::string>& cabinet = CabinetConstraints::optionKeys();
+    return std::find(cabinet.begin(), cabinet.end(), option) != cabinet.end() ? Geometry : Tuning;
+}
+
+double TSParameters::*DesignModel::member(Parameter param) {
+    switch (param) {
+        case Parameter::Fs: return &TSParameters::fs;
+        case Parameter::Qts: return &TSParameters::qts;
+        case Parameter::Vas: return &TSParameters::vas;
+        case Parameter::Re: return &TSParameters::re;
+        case Parameter::Sd: return &TSParameters::sd;
+        case Parameter::Xmax: return &TSParameters::xmax;
+        case Parameter::Vd: return &TSParameters::vd;
+        case Parameter::Le: return &TSParameters::le;
+        case Parameter::Cms: return &TSParameters::cms;
+        case Parameter::Mms: return &TSParameters::mms;
+        case Parameter::Bl: return &TSParameters::bl;
+    }
+    return &TSParameters::fs;
+}
+
+void DesignModel::computeTuning() {
+    EnclosureResult prev = result_;
+    result_ = calc_.calculateTuning(params_, type_, options_);
+    tuning_warnings_ = result_.warnings;
+    dirty_ |= Geometry;
+    // Only the tuning feeds the transfer function; a volume change alone stops at the geometry
+    if (result_.type != prev.type || result_.fc_or_fb != prev.fc_or_fb || result_.alpha != prev.alpha || result_.ql != prev.ql) {
+        dirty_ |= Transfer;
+    }
+}
+
+void DesignModel::computeGeometry() {
+    result_.warnings = tuning_warnings_;
+    calc_.calculateGeometry(result_, params_, options_);
+}
+
+void DesignModel::computeTransfer() {
+    transfer_ = calc_.transferFunction(params_, result_);
+    dirty_ |= Response;
+}
+
+void DesignModel::computeResponse() {
+    response_db_.resize(freqs_.size());
+    double peak = -1e9;
+    for (std::size_t i = 0; i < freqs_.size(); ++i) {
+        double mag = transfer_.den.empty() ? 0.0 : std::abs(transfer_.evaluate(freqs_[i]));
+        response_db_[i] = 20.0 * std::log10(mag > 1e-12 ? mag : 1e-12);
+        if (response_db_[i] > peak) peak = response_db_[i];
+    }
+    // Reference is the passband (0 dB) unless the curve never gets there
+    double ref = peak < 0.0 ? peak : 0.0;
+    f3_ = 0.0;
+    for (std::size_t i = 0; i < freqs_.size(); ++i) {
+        if (response_db_[i] >= ref - 3.0) {
+            f3_ = freqs_[i];
+            break;
+        }
+    }
+}
+
+}  // namespace speakerbox
@@ -0,0 +1,171 @@
+#include "plot.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace speakerbox {
+
+namespace {
+
+// Dot bit for subpixel (x, y) inside a cell, x in [0, 1], y in [0, 3]
+constexpr std::uint8_t kDotBits[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+
+void appendBraille(std::string& out, std::uint8_t bits) {
+    // U+2800 + bits in UTF-8
+    out += static_cast<char>(0xE2);
+    out += static_cast<char>(0xA0 | (bits >> 6));
+    out += static_cast<char>(0x80 | (bits & 0x3F));
+}
+
+void appendCursor(std::string& out, int row, int col) {
+    char buf[24];
+    std::snprintf(buf, sizeof(buf), "\033[%d;%dH", row, col);
+    out += buf;
+}
+
+}  // namespace
+
+BraillePlot::BraillePlot(int cols, int rows, double f_min, double f_max, double db_min, double db_max)
+    : cols_(cols), rows_(rows),
+      log_min_(std::log10(f_min)), log_scale_((2 * cols - 1) / (std::log10(f_max) - std::log10(f_min))),
+      db_min_(db_min), db_max_(db_max),
+      dots_(cols * rows, 0), colors_(cols * rows, 0),
+      front_dots_(cols * rows, 0), front_colors_(cols * rows, 0),
+      dirty_rows_(rows, true) {
+    drawGrid();
+}
+
+void BraillePlot::clear() {
+    for (int r = 0; r < rows_; ++r) {
+        for (int c = 0; c < cols_; ++c) {
+            if (dots_[r * cols_ + c]) dirty_rows_[r] = true;
+        }
+    }
+    std::fill(dots_.begin(), dots_.end(), 0);
+    std::fill(colors_.begin(), colors_.end(), 0);
+    drawGrid();
+}
+
+void BraillePlot::plot(const std::vector<double>& freqs, const std::vector<double>& db, std::uint8_t color) {
+    const int height = rows_ * 4;
+    bool have_prev = false;
+    int px0 = 0, py0 = 0;
+    for (std::size_t i = 0; i < freqs.size() && i < db.size(); ++i) {
+        if (!std::isfinite(db[i]) || freqs[i] <= 0.0) {
+            have_prev = false;
+            continue;
+        }
+        int px = pixelX(freqs[i]);
+        int py = pixelY(db[i]);
+        // Segments entirely above or below the window are dropped, the rest clipped
+        if (have_prev && !((py < 0 && py0 < 0) || (py >= height && py0 >= height))) {
+            line(px0, py0, px, py, color);
+        }
+        px0 = px;
+        py0 = py;
+        have_prev = true;
+    }
+}
+
+void BraillePlot::invalidate() {
+    std::fill(front_dots_.begin(), front_dots_.end(), 0xFF);
+    std::fill(dirty_rows_.begin(), dirty_rows_.end(), true);
+}
+
+std::string BraillePlot::frame(int row, int col) const {
+    std::string out;
+    char buf[16];
+    for (int r = 0; r < rows_; r += 2) {
+        double db = db_max_ - (db_max_ - db_min_) * (r * 4) / (rows_ * 4 - 1);
+        std::snprintf(buf, sizeof(buf), "%4.0f ", db);
+        appendCursor(out, row + r, col);
+        out += buf;
+    }
+    // Decade labels under the plot area
+    appendCursor(out, row + rows_, col);
+    out += std::string(kLabelWidth + cols_, ' ');
+    for (double decade = std::pow(10.0, std::ceil(log_min_)); pixelX(decade) < 2 * cols_; decade *= 10.0) {
+        std::snprintf(buf, sizeof(buf), "%g", decade);
+        appendCursor(out, row + rows_, col + kLabelWidth + pixelX(decade) / 2);
+        out += buf;
+    }
+    return out;
+}
+
+std::string BraillePlot::render(int row, int col, const std::vector<std::string>& palette) {
+    std::string out;
+    int current = -1;  // Palette entry in effect, so runs of one color emit it once
+    for (int r = 0; r < rows_; ++r) {
+        if (!dirty_rows_[r]) continue;
+        dirty_rows_[r] = false;
+        int run_end = -1;  // Cursor already sits after the previous emitted cell
+        for (int c = 0; c < cols_; ++c) {
+            int i = r * cols_ + c;
+            if (dots_[i] == front_dots_[i] && colors_[i] == front_colors_[i]) continue;
+            if (c != run_end) appendCursor(out, row + r, col + kLabelWidth + c);
+            if (colors_[i] != current && colors_[i] < palette.size()) {
+                out += palette[colors_[i]];
+                current = colors_[i];
+            }
+            appendBraille(out, dots_[i]);
+            front_dots_[i] = dots_[i];
+            front_colors_[i] = colors_[i];
+            run_end = c + 1;
+        }
+    }
+    if (!out.empty() && !palette.empty()) out += "\033[0m";
+    return out;
+}
+
+int BraillePlot::pixelX(double freq) const {
+    return static_cast<int>(std::lround((std::log10(freq) - log_min_) * log_scale_));
+}
+
+int BraillePlot::pixelY(double db) const {
+    // Clamped to a band around the window so clipped segments stay short
+    double py = (db_max_ - db) / (db_max_ - db_min_) * (rows_ * 4 - 1);
+    return static_cast<int>(std::lround(std::clamp(py, -4.0 * rows_, 8.0 * rows_)));
+}
+
+void BraillePlot::setDot(int px, int py, std::uint8_t color) {
+    if (px < 0 || py < 0 || px >= 2 * cols_ || py >= 4 * rows_) return;
+    int i = (py >> 2) * cols_ + (px >> 1);
+    std::uint8_t bit = kDotBits[py & 3][px & 1];
+    if ((dots_[i] & bit) && colors_[i] == color) return;
+    dots_[i] |= bit;
+    colors_[i] = color;
+    dirty_rows_[py >> 2] = true;
+}
+
+void BraillePlot::line(int x0, int y0, int x1, int y1, std::uint8_t color) {
+    // Bresenham; setDot clips
+    int dx = std::abs(x1 - x0), dy = -std::abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while (true) {
+        setDot(x0, y0, color);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+void BraillePlot::drawGrid() {
+    // Dotted verticals at decades, dotted horizontals every other label row
+    for (double decade = std::pow(10.0, std::ceil(log_min_)); pixelX(decade) < 2 * cols_; decade *= 10.0) {
+        for (int py = 0; py < 4 * rows_; py += 2) setDot(pixelX(decade), py, 0);
+    }
+    for (int r = 0; r < rows_; r += 2) {
+        for (int px = 0; px < 2 * cols_; px += 4) setDot(px, r * 4, 0);
+    }
+}
+
+}  // namespace speakerbox
@@ -0,0 +1,452 @@
+#include "render.h"
+#include "export.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace speakerbox {
+
+namespace {
+
+using Complex = std::complex<double>;
+
+constexpr std::uint16_t WAVE_FORMAT_PCM = 1;
+constexpr std::uint16_t WAVE_FORMAT_FLOAT = 3;
+constexpr std::uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// c0 + c1 s + c2 s^2
+struct Quadratic {
+    double c0, c1, c2;
+};
+
+// Roots of an ascending-power polynomial: exact zeros at the origin, the rest by Durand-Kerner
+std::vector<Complex> polynomialRoots(std::vector<double> c) {
+    while (c.size() > 1 && c.back() == 0.0) c.pop_back();
+    std::size_t origin = 0;
+    while (origin + 1 < c.size() && c[origin] == 0.0) ++origin;
+    std::vector<Complex> roots(origin, 0.0);
+    c.erase(c.begin(), c.begin() + origin);
+    const std::size_t n = c.size() - 1;
+    if (n == 0) return roots;
+
+    auto eval = [&](Complex s) {
+        Complex r = 0.0;
+        for (auto it = c.rbegin(); it != c.rend(); ++it) r = r * s + *it;
+        return r;
+    };
+    double radius = std::pow(std::abs(c[0] / c[n]), 1.0 / n);
+    std::vector<Complex> z(n);
+    for (std::size_t i = 0; i < n; ++i) z[i] = radius * std::pow(Complex(0.4, 0.9), static_cast<double>(i));
+    for (int iter = 0; iter < 500; ++iter) {
+        double moved = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            Complex den = c[n];
+            for (std::size_t j = 0; j < n; ++j) {
+                if (j != i) den *= z[i] - z[j];
+            }
+            Complex step = eval(z[i]) / den;
+            z[i] -= step;
+            moved = std::max(moved, std::abs(step));
+        }
+        if (moved < 1e-14 * radius) break;
+    }
+    roots.insert(roots.end(), z.begin(), z.end());
+    return roots;
+}
+
+// Conjugate pairs and pairs of real roots as monic quadratics, a lone real root as a linear factor
+std::vector<Quadratic> pairRoots(const std::vector<Complex>& roots) {
+    std::vector<Quadratic> factors;
+    std::vector<double> real;
+    for (const Complex& r : roots) {
+        if (std::abs(r.imag()) <= 1e-9 * std::abs(r)) real.push_back(r.real());
+        else if (r.imag() > 0.0) factors.push_back({std::norm(r), -2.0 * r.real(), 1.0});
+    }
+    std::sort(real.begin(), real.end(), [](double a, double b) { return std::abs(a) < std::abs(b); });
+    for (std::size_t i = 0; i + 1 < real.size(); i += 2) factors.push_back({real[i] * real[i + 1], -(real[i] + real[i + 1]), 1.0});
+    if (real.size() % 2) factors.push_back({-real.back(), 1.0, 0.0});
+    return factors;
+}
+
+double leading(const std::vector<double>& c) {
+    for (auto it = c.rbegin(); it != c.rend(); ++it) {
+        if (*it != 0.0) return *it;
+    }
+    return 0.0;
+}
+
+// Biquads run across every channel of an interleaved block in one pass per
+// section; the channel loop is the unit-stride one the compiler vectorizes
+class Cascade {
+public:
+    Cascade(const std::vector<Biquad>& sections, unsigned channels)
+        : sections_(sections), channels_(channels), state_(sections.size() * channels * 2, 0.0) {}
+
+    void process(double* data, std::size_t frames) {
+        const unsigned ch = channels_;
+        for (std::size_t s = 0; s < sections_.size(); ++s) {
+            const Biquad q = sections_[s];
+            double* s1 = &state_[s * ch * 2];
+            double* s2 = s1 + ch;
+            for (std::size_t f = 0; f < frames; ++f) {
+                double* x = data + f * ch;
+                for (unsigned c = 0; c < ch; ++c) {
+                    // Transposed direct form II
+                    double in = x[c];
+                    double out = q.b0 * in + s1[c];
+                    s1[c] = q.b1 * in - q.a1 * out + s2[c];
+                    s2[c] = q.b2 * in - q.a2 * out;
+                    x[c] = out;
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<Biquad> sections_;
+    unsigned channels_;
+    std::vector<double> state_;
+};
+
+struct WavFormat {
+    std::uint16_t format;  // PCM or float after unwrapping EXTENSIBLE
+    std::uint16_t channels;
+    std::uint32_t sample_rate;
+    std::uint16_t bits;
+    std::uint16_t block_align;
+    std::uint64_t data_bytes;  // UINT32_MAX or 0 when the writer never patched it
+};
+
+std::uint16_t readU16(const unsigned char* p) {
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+std::uint32_t readU32(const unsigned char* p) {
+    return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) | (static_cast<std::uint32_t>(p[2]) << 16) |
+           (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+template <typename T>
+void appendLe(std::string& out, T value) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) out += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+// Leaves file positioned at the first data byte
+bool readWavHeader(std::FILE* file, WavFormat& wav, std::string& error) {
+    unsigned char riff[12];
+    if (std::fread(riff, 1, 12, file) != 12 || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        error = "not a RIFF/WAVE file";
+        return false;
+    }
+    bool have_fmt = false;
+    unsigned char chunk[8];
+    while (std::fread(chunk, 1, 8, file) == 8) {
+        std::uint32_t size = readU32(chunk + 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[40] = {};
+            std::size_t want = std::min<std::size_t>(size, sizeof(fmt));
+            if (size < 16 || std::fread(fmt, 1, want, file) != want) break;
+            wav.format = readU16(fmt);
+            wav.channels = readU16(fmt + 2);
+            wav.sample_rate = readU32(fmt + 4);
+            wav.block_align = readU16(fmt + 12);
+            wav.bits = readU16(fmt + 14);
+            if (wav.format == WAVE_FORMAT_EXTENSIBLE && size >= 26) wav.format = readU16(fmt + 24);  // Sub-format GUID
+            if (std::fseek(file, static_cast<long>(size - want + (size & 1)), SEEK_CUR) != 0) break;
+            have_fmt = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_fmt) break;
+            wav.data_bytes = size;
+            bool supported = (wav.format == WAVE_FORMAT_PCM && (wav.bits == 16 || wav.bits == 24 || wav.bits == 32)) ||
+                             (wav.format == WAVE_FORMAT_FLOAT && wav.bits == 32);
+            if (!supported || wav.channels == 0 || wav.block_align != wav.channels * (wav.bits / 8) || wav.sample_rate == 0) {
+                error = "unsupported WAV format (16/24/32-bit PCM or 32-bit float)";
+                return false;
+            }
+            return true;
+        } else if (std::fseek(file, static_cast<long>(size + (size & 1)), SEEK_CUR) != 0) {
+            break;
+        }
+    }
+    error = "no audio data";
+    return false;
+}
+
+std::string wavHeader(const WavFormat& wav, std::uint64_t frames) {
+    std::uint32_t data = static_cast<std::uint32_t>(std::min<std::uint64_t>(frames * wav.block_align, 0xFFFFFFF0u));
+    std::string out = "RIFF";
+    appendLe<std::uint32_t>(out, 36 + data + (data & 1));
+    out += "WAVEfmt ";
+    appendLe<std::uint32_t>(out, 16);
+    appendLe<std::uint16_t>(out, wav.format);
+    appendLe<std::uint16_t>(out, wav.channels);
+    appendLe<std::uint32_t>(out, wav.sample_rate);
+    appendLe<std::uint32_t>(out, wav.sample_rate * wav.block_align);
+    appendLe<std::uint16_t>(out, wav.block_align);
+    appendLe<std::uint16_t>(out, wav.bits);
+    out += "data";
+    appendLe<std::uint32_t>(out, data);
+    return out;
+}
+
+void decode(const WavFormat& wav, const char* in, std::size_t samples, double* out) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    if (wav.format == WAVE_FORMAT_FLOAT) {
+        for (std::size_t i = 0; i < samples; ++i) {
+            float v;
+            std::memcpy(&v, p + 4 * i, 4);  // Little-endian hosts
+            out[i] = v;
+        }
+    } else if (wav.bits == 16) {
+        for (std::size_t i = 0; i < samples; ++i) out[i] = static_cast<std::int16_t>(readU16(p + 2 * i)) * (1.0 / 32768.0);
+    } else if (wav.bits == 24) {
+        for (std::size_t i = 0; i < samples; ++i) {
+            std::int32_t v = static_cast<std::int32_t>(static_cast<std::uint32_t>(p[3 * i]) << 8 | static_cast<std::uint32_t>(p[3 * i + 1]) << 16 |
+                                                       static_cast<std::uint32_t>(p[3 * i + 2]) << 24);
+            out[i] = (v >> 8) * (1.0 / 8388608.0);
+        }
+    } else {
+        for (std::size_t i = 0; i < samples; ++i) out[i] = static_cast<std::int32_t>(readU32(p + 4 * i)) * (1.0 / 2147483648.0);
+    }
+}
+
+// Appends the encoded samples; returns how many were clamped
+std::uint64_t encode(const WavFormat& wav, const double* in, std::size_t samples, std::string& out) {
+    std::uint64_t clipped = 0;
+    if (wav.format == WAVE_FORMAT_FLOAT) {
+        for (std::size_t i = 0; i < samples; ++i) {
+            float v = static_cast<float>(in[i]);
+            out.append(reinterpret_cast<const char*>(&v), 4);
+        }
+        return 0;
+    }
+    const double scale = std::ldexp(1.0, wav.bits - 1);
+    for (std::size_t i = 0; i < samples; ++i) {
+        double v = std::round(in[i] * scale);
+        if (v >= scale || v < -scale) {
+            ++clipped;
+            v = std::clamp(v, -scale, scale - 1.0);
+        }
+        std::uint32_t u = static_cast<std::uint32_t>(static_cast<std::int32_t>(v));
+        for (int b = 0; b < wav.bits / 8; ++b) out += static_cast<char>((u >> (8 * b)) & 0xFF);
+    }
+    return clipped;
+}
+
+// Reads fixed-size blocks ahead on a background thread; the block returned by
+// next() stays valid until the following call
+class BlockReader {
+public:
+    BlockReader(std::FILE* file, std::size_t block_bytes, std::uint64_t limit)
+        : file_(file), block_bytes_(block_bytes), remaining_(limit), front_(0), pending_(true), stop_(false) {
+        thread_ = std::thread(&BlockReader::run, this);
+    }
+
+    ~BlockReader() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    const std::string& next() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !pending_; });
+        front_ ^= 1;
+        pending_ = true;
+        cv_.notify_all();
+        return buffers_[front_];
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this] { return pending_ || stop_; });
+            if (stop_) break;
+            std::string& buf = buffers_[front_ ^ 1];
+            lock.unlock();
+            std::size_t want = static_cast<std::size_t>(std::min<std::uint64_t>(block_bytes_, remaining_));
+            buf.resize(want);
+            std::size_t got = want ? std::fread(&buf[0], 1, want, file_) : 0;
+            buf.resize(got);
+            remaining_ -= got;
+            lock.lock();
+            pending_ = false;
+            cv_.notify_all();
+        }
+    }
+
+    std::FILE* file_;
+    std::size_t block_bytes_;
+    std::uint64_t remaining_;
+    std::string buffers_[2];
+    int front_;
+    bool pending_;
+    bool stop_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+}  // namespace
+
+std::vector<Biquad> designBiquads(const TransferFunction& tf, double sample_rate, double prewarp_freq) {
+    std::vector<Biquad> sections;
+    double gain = leading(tf.num) / leading(tf.den);
+    if (tf.den.empty() || gain == 0.0) return sections;
+    std::vector<Quadratic> poles = pairRoots(polynomialRoots(tf.den));
+    std::vector<Quadratic> zeros = pairRoots(polynomialRoots(tf.num));
+    // Second-order zero factors go with second-order poles so every section stays proper
+    std::stable_sort(zeros.begin(), zeros.end(), [](const Quadratic& a, const Quadratic& b) { return a.c2 > b.c2; });
+    std::stable_sort(poles.begin(), poles.end(), [](const Quadratic& a, const Quadratic& b) { return a.c2 > b.c2; });
+
+    double k = 2.0 * sample_rate;
+    double w0 = 2.0 * PI * prewarp_freq;
+    if (prewarp_freq > 0.0 && prewarp_freq < 0.45 * sample_rate) k = w0 / std::tan(w0 / (2.0 * sample_rate));
+
+    for (std::size_t i = 0; i < std::max(poles.size(), zeros.size()); ++i) {
+        Quadratic b = i < zeros.size() ? zeros[i] : Quadratic{1.0, 0.0, 0.0};
+        Quadratic a = i < poles.size() ? poles[i] : Quadratic{1.0, 0.0, 0.0};
+        if (i == 0) {
+            b.c0 *= gain;
+            b.c1 *= gain;
+            b.c2 *= gain;
+        }
+        // s = k (1 - 1/z) / (1 + 1/z), cleared of (1 + 1/z)^order
+        double a0, a1, a2, b0, b1, b2;
+        if (a.c2 == 0.0 && b.c2 == 0.0) {
+            a0 = a.c0 + a.c1 * k;
+            a1 = a.c0 - a.c1 * k;
+            a2 = 0.0;
+            b0 = b.c0 + b.c1 * k;
+            b1 = b.c0 - b.c1 * k;
+            b2 = 0.0;
+        } else {
+            a0 = a.c0 + a.c1 * k + a.c2 * k * k;
+            a1 = 2.0 * (a.c0 - a.c2 * k * k);
+            a2 = a.c0 - a.c1 * k + a.c2 * k * k;
+            b0 = b.c0 + b.c1 * k + b.c2 * k * k;
+            b1 = 2.0 * (b.c0 - b.c2 * k * k);
+            b2 = b.c0 - b.c1 * k + b.c2 * k * k;
+        }
+        sections.push_back({b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0});
+    }
+    return sections;
+}
+
+TransferFunction excursionTransfer(const TSParameters& params, const EnclosureResult& result) {
+    TransferFunction tf;
+    Calculator calc;
+    TransferFunction response = calc.transferFunction(params, result);
+    TSParameters full = completeParameters(params);
+    if (response.den.empty() || params.re <= 0.0 || full.bl <= 0.0) return tf;
+    // Static displacement per volt, Bl Cms / Re, stiffened by the box unless a vent vents it
+    double x0 = full.bl * full.cms / params.re;
+    tf.den = response.den;
+    if (response.den.size() == 5) {
+        // Vented: the cone rests at Fb, where the vent does the work
+        double wb = 2.0 * PI * result.fc_or_fb;
+        double inv_ql = result.ql > 0.0 ? 1.0 / result.ql : 0.0;
+        tf.num = {x0 * response.den[0], x0 * response.den[0] * inv_ql / wb, x0 * response.den[0] / (wb * wb)};
+    } else {
+        tf.num = {x0 / (1.0 + result.alpha) * response.den[0]};
+    }
+    return tf;
+}
+
+RenderOptions::RenderOptions() : drive(2.83), block_frames(4096), check_excursion(true) {}
+
+Renderer::Renderer(const TSParameters& params, const EnclosureResult& result, const RenderOptions& options)
+    : tuning_(result.fc_or_fb), xmax_(params.xmax * 1e-3), options_(options) {
+    Calculator calc;
+    response_ = calc.transferFunction(params, result);
+    excursion_ = excursionTransfer(params, result);
+}
+
+RenderStats Renderer::render(const std::string& input, const std::string& output) const {
+    RenderStats stats{};
+    std::FILE* in = std::fopen(input.c_str(), "rb");
+    if (!in) {
+        stats.error = "cannot open " + input;
+        return stats;
+    }
+    WavFormat wav{};
+    if (!readWavHeader(in, wav, stats.error)) {
+        std::fclose(in);
+        return stats;
+    }
+    stats.channels = wav.channels;
+    stats.sample_rate = wav.sample_rate;
+    bool sized = wav.data_bytes != 0 && wav.data_bytes != 0xFFFFFFFFu;
+    std::uint64_t declared = sized ? wav.data_bytes / wav.block_align : 0;
+
+    const std::size_t frames_per_block = std::max<std::size_t>(1, options_.block_frames);
+    const std::size_t block_bytes = frames_per_block * wav.block_align;
+    Cascade response(designBiquads(response_, wav.sample_rate, tuning_), wav.channels);
+    std::vector<Biquad> excursion_sections = designBiquads(excursion_, wav.sample_rate, tuning_);
+    bool check = options_.check_excursion && !excursion_sections.empty() && xmax_ > 0.0;
+    Cascade excursion(excursion_sections, wav.channels);
+    const double volts = options_.drive * std::sqrt(2.0);  // Peak volts at full scale
+
+    std::vector<double> samples(frames_per_block * wav.channels), cone(check ? samples.size() : 0);
+    {
+        BlockWriter writer(output, block_bytes + 64);
+        if (!writer.ok()) {
+            std::fclose(in);
+            stats.error = "cannot write " + output;
+            return stats;
+        }
+        writer.block() += wavHeader(wav, declared);
+        BlockReader reader(in, block_bytes, sized ? wav.data_bytes : UINT64_MAX);
+        while (true) {
+            const std::string& raw = reader.next();
+            std::size_t frames = raw.size() / wav.block_align;
+            if (frames == 0) break;
+            std::size_t count = frames * wav.channels;
+            decode(wav, raw.data(), count, samples.data());
+            if (check) {
+                std::copy(samples.begin(), samples.begin() + count, cone.begin());
+                excursion.process(cone.data(), frames);
+                double peak = 0.0;
+                for (std::size_t i = 0; i < count; ++i) peak = std::max(peak, std::abs(cone[i]));
+                peak *= volts;
+                stats.peak_excursion = std::max(stats.peak_excursion, peak * 1e3);
+                if (peak > xmax_) {
+                    double start = static_cast<double>(stats.frames) / wav.sample_rate;
+                    double end = static_cast<double>(stats.frames + frames) / wav.sample_rate;
+                    if (!stats.over_xmax.empty() && stats.over_xmax.back().second >= start) stats.over_xmax.back().second = end;
+                    else if (stats.over_xmax.size() < kMaxSpans) stats.over_xmax.push_back({start, end});
+                }
+            }
+            response.process(samples.data(), frames);
+            stats.clipped += encode(wav, samples.data(), count, writer.block());
+            writer.commit();
+            stats.frames += frames;
+        }
+        if ((stats.frames * wav.block_align) & 1) writer.block() += '\0';
+        writer.close();
+        stats.ok = writer.ok();
+        if (!stats.ok) stats.error = "write failed: " + output;
+    }
+    std::fclose(in);
+
+    if (stats.ok && stats.frames != declared) {
+        // Input was shorter than declared, or streamed without sizes
+        std::FILE* out = std::fopen(output.c_str(), "r+b");
+        std::string header = wavHeader(wav, stats.frames);
+        stats.ok = out && std::fwrite(header.data(), 1, header.size(), out) == header.size();
+        if (out && std::fclose(out) != 0) stats.ok = false;
+        if (!stats.ok) stats.error = "cannot finalize " + output;
+    }
+    return stats;
+}
+
+}  // namespace speakerbox
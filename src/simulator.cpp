@@ -0,0 +1,290 @@
+#include "simulator.h"
+#include "constants.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+namespace speakerbox {
+
+namespace {
+
+constexpr double REFERENCE_SCALE = 0.01;  // Small-signal companion run for compression
+constexpr double SETTLE_TIME = 0.25;  // s, at least, before measuring
+constexpr double WINDOW_CYCLES = 16.0;  // Of the lowest tone, Hann windowed
+constexpr double COPPER_TEMP_COEFF = 0.00393;  // 1/K
+
+inline double poly(const double* c, double u) {
+    double r = 0.0;
+    for (int k = Simulator::kMaxOrder - 1; k >= 0; --k) r = r * u + c[k];
+    return r;
+}
+
+inline double polyDerivative(const double* c, double u) {
+    double r = 0.0;
+    for (int k = Simulator::kMaxOrder - 1; k >= 1; --k) r = r * u + k * c[k];
+    return r;
+}
+
+void copyPolynomial(const std::vector<double>& in, double* out) {
+    for (int k = 0; k < Simulator::kMaxOrder; ++k) out[k] = k < static_cast<int>(in.size()) ? in[k] : 0.0;
+    if (in.empty()) out[0] = 1.0;
+}
+
+}  // namespace
+
+NonlinearParameters::NonlinearParameters() : bl({1.0, 0.0, -0.25}), cms({1.0, 0.0, -0.35}), le({1.0, -0.1}), thermal_resistance(0.0) {}
+
+Simulator::Simulator(const TSParameters& params, const EnclosureResult& result, const NonlinearParameters& nonlinear)
+    : ok_(false), sample_rate_(96000.0), re_(params.re), le_(params.le * 1e-3), bl_(0.0), mms_(0.0),
+      cms_(0.0), rms_(0.0), sd_(params.sd * 1e-4), xmax_(params.xmax * 1e-3),
+      thermal_resistance_(nonlinear.thermal_resistance), k_box_(0.0), map_(0.0), rap_(0.0),
+      radiate_cone_(result.type != "Bandpass") {
+    copyPolynomial(nonlinear.bl, bl_poly_);
+    copyPolynomial(nonlinear.cms, cms_poly_);
+    copyPolynomial(nonlinear.le, le_poly_);
+    if (params.fs <= 0.0 || params.qts <= 0.0 || sd_ <= 0.0 || re_ <= 0.0 || result.vb <= 0.0) return;
+
+    // Fill in whatever the driver sheet left out from Fs, Qts and Vas
+    const double rho_c2 = AIR_DENSITY * SPEED_SOUND * SPEED_SOUND;
+    TSParameters full = completeParameters(params);
+    cms_ = full.cms;
+    mms_ = full.mms * 1e-3;
+    bl_ = full.bl;
+    rms_ = mechanicalResistance(full);
+    if (xmax_ <= 0.0) xmax_ = 1e-3;
+
+    k_box_ = rho_c2 / (result.vb * 1e-3);
+    if (result.type != "Sealed" && result.fc_or_fb > 0.0) {
+        // Vent (or radiator, or line) as a mass tuned against the box compliance to Fb;
+        // leakage is lumped into the vent loss
+        double wb = 2.0 * PI * result.fc_or_fb;
+        map_ = k_box_ / (wb * wb);
+        rap_ = result.ql > 0.0 ? wb * map_ / result.ql : 0.0;
+    }
+    ok_ = true;
+}
+
+std::vector<DistortionTest> Simulator::sweep(const std::vector<double>& freqs, const std::vector<double>& voltages) {
+    std::vector<DistortionTest> tests;
+    for (double v : voltages) {
+        for (double f : freqs) tests.push_back({f, v, 0.0});
+    }
+    return tests;
+}
+
+Simulator::Job Simulator::makeJob(const DistortionTest& test, double scale) const {
+    Job job{};
+    double peak = test.voltage * std::sqrt(2.0) * scale;
+    double f1 = test.frequency, f2 = test.frequency2;
+    double f_low = f1;
+    if (f2 > 0.0) {
+        // SMPTE: low tone at four times the high tone's amplitude
+        job.amp1 = 0.8 * peak;
+        job.amp2 = 0.2 * peak;
+        f_low = std::min(f1, f2);
+        double hi = std::max(f1, f2), lo = f_low;
+        double bins[kBins] = {hi, lo, hi - lo, hi + lo, hi - 2.0 * lo, hi + 2.0 * lo};
+        std::copy(bins, bins + kBins, job.bins);
+    } else {
+        job.amp1 = peak;
+        for (int b = 0; b < kBins; ++b) job.bins[b] = f1 * (b + 1);
+    }
+    // Steady-state coil heating from the power into Re; the compression run sees it, the reference does not
+    double power = test.voltage * scale * test.voltage * scale / re_;
+    job.re = re_ * (1.0 + COPPER_TEMP_COEFF * thermal_resistance_ * power);
+    job.w1 = 2.0 * PI * f1;
+    job.w2 = 2.0 * PI * f2;
+    job.settle = static_cast<long>(std::max(SETTLE_TIME, 10.0 / f_low) * sample_rate_);
+    job.window = static_cast<long>(WINDOW_CYCLES / f_low * sample_rate_);
+    return job;
+}
+
+std::vector<DistortionResult> Simulator::run(const std::vector<DistortionTest>& tests) const {
+    std::vector<DistortionResult> results(tests.size(), DistortionResult{});
+    if (!ok_ || tests.empty()) return results;
+
+    // Every test gets a small-signal companion; sort by length so batches finish together
+    std::vector<Job> jobs;
+    for (const auto& test : tests) {
+        jobs.push_back(makeJob(test, 1.0));
+        jobs.push_back(makeJob(test, REFERENCE_SCALE));
+    }
+    std::vector<std::size_t> order(jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return jobs[a].settle + jobs[a].window < jobs[b].settle + jobs[b].window;
+    });
+    std::vector<Job> sorted(jobs.size());
+    for (std::size_t k = 0; k < order.size(); ++k) sorted[k] = jobs[order[k]];
+
+    std::vector<Measurement> measured(jobs.size());
+    std::size_t batches = (jobs.size() + kLanes - 1) / kLanes;
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+        for (std::size_t b = next++; b < batches; b = next++) {
+            int count = static_cast<int>(std::min<std::size_t>(kLanes, jobs.size() - b * kLanes));
+            runBatch(&sorted[b * kLanes], count, &measured[b * kLanes]);
+        }
+    };
+    std::size_t workers = parallelWorkers(batches, 1);
+    std::vector<std::thread> threads;
+    for (std::size_t w = 1; w < workers; ++w) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+
+    std::vector<Measurement> by_job(jobs.size());
+    for (std::size_t k = 0; k < order.size(); ++k) by_job[order[k]] = measured[k];
+
+    // Far-field pressure at 1 m in half space: p = rho * w * U / (2 pi r) = rho * f * U
+    for (std::size_t t = 0; t < tests.size(); ++t) {
+        const Job& job = jobs[2 * t];
+        const Measurement& full = by_job[2 * t];
+        const Measurement& ref = by_job[2 * t + 1];
+        double p[kBins];
+        for (int b = 0; b < kBins; ++b) p[b] = AIR_DENSITY * job.bins[b] * full.mag[b];
+        double p_ref = AIR_DENSITY * job.bins[0] * ref.mag[0] / REFERENCE_SCALE;
+
+        DistortionResult& r = results[t];
+        r.spl = 20.0 * std::log10(std::max(p[0], 1e-12) / std::sqrt(2.0) / 20e-6);
+        r.compression = 20.0 * std::log10(std::max(p_ref, 1e-12) / std::max(p[0], 1e-12));
+        r.peak_excursion = full.peak_x * 1e3;
+        double sum = 0.0;
+        for (int b = tests[t].frequency2 > 0.0 ? 2 : 1; b < kBins; ++b) sum += p[b] * p[b];
+        double ratio = p[0] > 0.0 ? 100.0 * std::sqrt(sum) / p[0] : 0.0;
+        if (tests[t].frequency2 > 0.0) {
+            r.imd = ratio;
+        } else {
+            r.thd = ratio;
+            r.h2 = p[0] > 0.0 ? 100.0 * p[1] / p[0] : 0.0;
+            r.h3 = p[0] > 0.0 ? 100.0 * p[2] / p[0] : 0.0;
+        }
+    }
+    return results;
+}
+
+void Simulator::runBatch(const Job* jobs, int count, Measurement* out) const {
+    constexpr int L = kLanes;
+    const double dt = 1.0 / sample_rate_;
+    const double inv_xmax = 1.0 / xmax_;
+    const double cone = radiate_cone_ ? sd_ : 0.0;
+    const bool vented = map_ > 0.0;
+    const bool inductive = le_ > 0.0;
+
+    // State and drive per lane
+    double i[L] = {}, x[L] = {}, v[L] = {}, q[L] = {}, qd[L] = {};
+    double amp1[L] = {}, amp2[L] = {}, re[L];
+    double z1r[L], z1i[L], r1r[L], r1i[L], z2r[L], z2i[L], r2r[L], r2i[L];  // Tone phasors, half-step rotations
+    double acc_r[kBins][L] = {}, acc_i[kBins][L] = {}, ph_r[kBins][L], ph_i[kBins][L], rot_r[kBins][L], rot_i[kBins][L];
+    double wp_r[L], wp_i[L], wr_r[L], wr_i[L];  // Hann window phasor
+    long start[L], end[L];
+    double peak[L] = {};
+    long total = 0;
+    for (int l = 0; l < L; ++l) {
+        const Job& job = jobs[l < count ? l : 0];
+        re[l] = job.re;
+        if (l < count) {
+            amp1[l] = job.amp1;
+            amp2[l] = job.amp2;
+        }
+        z1r[l] = 1.0; z1i[l] = 0.0; r1r[l] = std::cos(job.w1 * dt / 2); r1i[l] = std::sin(job.w1 * dt / 2);
+        z2r[l] = 1.0; z2i[l] = 0.0; r2r[l] = std::cos(job.w2 * dt / 2); r2i[l] = std::sin(job.w2 * dt / 2);
+        for (int b = 0; b < kBins; ++b) {
+            ph_r[b][l] = 1.0; ph_i[b][l] = 0.0;
+            rot_r[b][l] = std::cos(2.0 * PI * job.bins[b] * dt);
+            rot_i[b][l] = -std::sin(2.0 * PI * job.bins[b] * dt);
+        }
+        double wstep = 2.0 * PI / job.window;
+        wp_r[l] = std::cos(-wstep * job.settle); wp_i[l] = std::sin(-wstep * job.settle);
+        wr_r[l] = std::cos(wstep); wr_i[l] = std::sin(wstep);
+        start[l] = l < count ? job.settle : 0;
+        end[l] = l < count ? job.settle + job.window : 0;
+        total = std::max(total, end[l]);
+    }
+
+    // dy/dt for all lanes at drive voltage vin
+    auto derivative = [&](const double* vin, const double* I, const double* X, const double* V, const double* Q, const double* QD,
+                          double* dI, double* dX, double* dV, double* dQ, double* dQD) {
+        for (int l = 0; l < L; ++l) {
+            double u = X[l] * inv_xmax;
+            double blx = bl_ * poly(bl_poly_, u);
+            double kx = 1.0 / (cms_ * std::max(poly(cms_poly_, u), 0.05));
+            double lex = le_ * std::max(poly(le_poly_, u), 0.05);
+            double dlex = le_ * polyDerivative(le_poly_, u) * inv_xmax;
+            double cur = inductive ? I[l] : (vin[l] - blx * V[l]) / re[l];
+            double p = -k_box_ * (sd_ * X[l] + Q[l]);
+            dI[l] = inductive ? (vin[l] - re[l] * cur - blx * V[l] - dlex * V[l] * cur) / lex : 0.0;
+            dX[l] = V[l];
+            dV[l] = (blx * cur - rms_ * V[l] - kx * X[l] + sd_ * p + 0.5 * dlex * cur * cur) / mms_;
+            dQ[l] = vented ? QD[l] : 0.0;
+            dQD[l] = vented ? (p - rap_ * QD[l]) / map_ : 0.0;
+        }
+    };
+
+    double v0[L], vh[L], v1[L];
+    double k1[5][L], k2[5][L], k3[5][L], k4[5][L], tmp[5][L];
+    for (long n = 0; n < total; ++n) {
+        // Drive at t, t + dt/2, t + dt
+        for (int l = 0; l < L; ++l) {
+            v0[l] = amp1[l] * z1i[l] + amp2[l] * z2i[l];
+            double a = z1r[l] * r1r[l] - z1i[l] * r1i[l], b = z1r[l] * r1i[l] + z1i[l] * r1r[l];
+            double c = z2r[l] * r2r[l] - z2i[l] * r2i[l], d = z2r[l] * r2i[l] + z2i[l] * r2r[l];
+            vh[l] = amp1[l] * b + amp2[l] * d;
+            z1r[l] = a * r1r[l] - b * r1i[l]; z1i[l] = a * r1i[l] + b * r1r[l];
+            z2r[l] = c * r2r[l] - d * r2i[l]; z2i[l] = c * r2i[l] + d * r2r[l];
+            v1[l] = amp1[l] * z1i[l] + amp2[l] * z2i[l];
+        }
+
+        derivative(v0, i, x, v, q, qd, k1[0], k1[1], k1[2], k1[3], k1[4]);
+        for (int l = 0; l < L; ++l) {
+            tmp[0][l] = i[l] + 0.5 * dt * k1[0][l]; tmp[1][l] = x[l] + 0.5 * dt * k1[1][l]; tmp[2][l] = v[l] + 0.5 * dt * k1[2][l];
+            tmp[3][l] = q[l] + 0.5 * dt * k1[3][l]; tmp[4][l] = qd[l] + 0.5 * dt * k1[4][l];
+        }
+        derivative(vh, tmp[0], tmp[1], tmp[2], tmp[3], tmp[4], k2[0], k2[1], k2[2], k2[3], k2[4]);
+        for (int l = 0; l < L; ++l) {
+            tmp[0][l] = i[l] + 0.5 * dt * k2[0][l]; tmp[1][l] = x[l] + 0.5 * dt * k2[1][l]; tmp[2][l] = v[l] + 0.5 * dt * k2[2][l];
+            tmp[3][l] = q[l] + 0.5 * dt * k2[3][l]; tmp[4][l] = qd[l] + 0.5 * dt * k2[4][l];
+        }
+        derivative(vh, tmp[0], tmp[1], tmp[2], tmp[3], tmp[4], k3[0], k3[1], k3[2], k3[3], k3[4]);
+        for (int l = 0; l < L; ++l) {
+            tmp[0][l] = i[l] + dt * k3[0][l]; tmp[1][l] = x[l] + dt * k3[1][l]; tmp[2][l] = v[l] + dt * k3[2][l];
+            tmp[3][l] = q[l] + dt * k3[3][l]; tmp[4][l] = qd[l] + dt * k3[4][l];
+        }
+        derivative(v1, tmp[0], tmp[1], tmp[2], tmp[3], tmp[4], k4[0], k4[1], k4[2], k4[3], k4[4]);
+        for (int l = 0; l < L; ++l) {
+            const double h = dt / 6.0;
+            i[l] += h * (k1[0][l] + 2.0 * k2[0][l] + 2.0 * k3[0][l] + k4[0][l]);
+            x[l] += h * (k1[1][l] + 2.0 * k2[1][l] + 2.0 * k3[1][l] + k4[1][l]);
+            v[l] += h * (k1[2][l] + 2.0 * k2[2][l] + 2.0 * k3[2][l] + k4[2][l]);
+            q[l] += h * (k1[3][l] + 2.0 * k2[3][l] + 2.0 * k3[3][l] + k4[3][l]);
+            qd[l] += h * (k1[4][l] + 2.0 * k2[4][l] + 2.0 * k3[4][l] + k4[4][l]);
+        }
+
+        // Hann-windowed single-bin DFTs of the radiated volume velocity
+        for (int l = 0; l < L; ++l) {
+            double gate = (n >= start[l] && n < end[l]) ? 1.0 : 0.0;
+            double y = gate * (0.5 - 0.5 * wp_r[l]) * (cone * v[l] + qd[l]);
+            double a = wp_r[l] * wr_r[l] - wp_i[l] * wr_i[l];
+            wp_i[l] = wp_r[l] * wr_i[l] + wp_i[l] * wr_r[l];
+            wp_r[l] = a;
+            peak[l] = std::max(peak[l], gate * std::abs(x[l]));
+            for (int b = 0; b < kBins; ++b) {
+                acc_r[b][l] += y * ph_r[b][l];
+                acc_i[b][l] += y * ph_i[b][l];
+                double c = ph_r[b][l] * rot_r[b][l] - ph_i[b][l] * rot_i[b][l];
+                ph_i[b][l] = ph_r[b][l] * rot_i[b][l] + ph_i[b][l] * rot_r[b][l];
+                ph_r[b][l] = c;
+            }
+        }
+    }
+
+    for (int l = 0; l < count; ++l) {
+        // Hann coherent gain is 1/2
+        double scale = 4.0 / jobs[l].window;
+        for (int b = 0; b < kBins; ++b) out[l].mag[b] = scale * std::hypot(acc_r[b][l], acc_i[b][l]);
+        out[l].peak_x = peak[l];
+    }
+}
+
+}  // namespace speakerbox
@@ -0,0 +1,120 @@
+#include "transient.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace speakerbox {
+
+TransientAnalyzer::TransientAnalyzer(double sample_rate, std::size_t length, double max_freq)
+    : sample_rate_(sample_rate), max_freq_(max_freq), plan_(FftPlan::get(length)) {
+    const std::size_t n = plan_->size(), bins = plan_->bins();
+    const double df = sample_rate_ / n;
+    const double nyquist = sample_rate_ / 2.0, knee = nyquist / std::sqrt(2.0);
+    taper_.resize(bins);
+    for (std::size_t k = 0; k < bins; ++k) {
+        double f = k * df;
+        taper_[k] = f <= knee ? 1.0 : 0.5 * (1.0 + std::cos(PI * (f - knee) / (nyquist - knee)));
+    }
+    // Hann centred on t = 0, with the upper half of the buffer as negative time
+    window_.resize(n);
+    for (std::size_t i = 0; i < n; ++i) window_[i] = 0.5 * (1.0 + std::cos(2.0 * PI * i / n));
+}
+
+TransientResult TransientAnalyzer::analyze(const TransferFunction& tf, double tuning) const {
+    Workspace ws = makeWorkspace();
+    TransientResult result;
+    result.metrics = measure(tf, tuning, ws, &result);
+    return result;
+}
+
+std::vector<TransientMetrics> TransientAnalyzer::analyzeBatch(const Calculator& calc, const std::vector<TSParameters>& params,
+                                                              const std::vector<EnclosureResult>& results) const {
+    std::size_t count = std::min(params.size(), results.size());
+    std::vector<TransientMetrics> metrics(count);
+    parallelFor(count, 16, [&](std::size_t begin, std::size_t end) {
+        Workspace ws = makeWorkspace();
+        for (std::size_t i = begin; i < end; ++i) {
+            metrics[i] = measure(calc.transferFunction(params[i], results[i]), results[i].fc_or_fb, ws, nullptr);
+        }
+    });
+    return metrics;
+}
+
+TransientAnalyzer::Workspace TransientAnalyzer::makeWorkspace() const {
+    Workspace ws;
+    ws.spectrum.resize(plan_->bins());
+    ws.weighted.resize(plan_->bins());
+    ws.work.resize(plan_->workSize());
+    ws.impulse.resize(plan_->size());
+    ws.ramp.resize(plan_->size());
+    ws.step.resize(plan_->size() / 2);
+    return ws;
+}
+
+TransientMetrics TransientAnalyzer::measure(const TransferFunction& tf, double tuning, Workspace& ws, TransientResult* curves) const {
+    const std::size_t n = plan_->size(), bins = plan_->bins();
+    const double df = sample_rate_ / n;
+
+    // Sample the response, rolling it off before Nyquist so the impulse does not ring
+    for (std::size_t k = 0; k < bins; ++k) ws.spectrum[k] = taper_[k] * tf.evaluate(k * df);
+    ws.spectrum[0] = ws.spectrum[0].real();
+    ws.spectrum[bins - 1] = ws.spectrum[bins - 1].real();
+    plan_->inverse(ws.spectrum.data(), ws.impulse.data(), ws.work.data());
+
+    // The band limit is zero-phase, so part of the impulse wraps to the end of
+    // the buffer; the upper half counts as negative time
+    const std::size_t causal = n / 2;
+    double sum = 0.0, peak = 0.0, low = 0.0;
+    for (std::size_t i = causal; i < n; ++i) sum += ws.impulse[i];
+    for (std::size_t i = 0; i < causal; ++i) {
+        sum += ws.impulse[i];
+        ws.step[i] = sum;
+        peak = std::max(peak, std::abs(sum));
+        low = std::min(low, sum);
+    }
+    TransientMetrics metrics{};
+    if (peak > 0.0) {
+        metrics.step_undershoot = -low / peak * 100.0;
+        std::size_t last = 0;
+        for (std::size_t i = 0; i < causal; ++i) {
+            if (std::abs(ws.step[i]) > 0.01 * peak) last = i;
+        }
+        metrics.decay_time = (last + 1) * 1000.0 / sample_rate_;
+    }
+    if (curves) {
+        curves->impulse.assign(ws.impulse.begin(), ws.impulse.begin() + causal);
+        curves->step.assign(ws.step.begin(), ws.step.begin() + causal);
+    }
+
+    // Group delay of the windowed impulse, time measured from the wrap point
+    for (std::size_t i = 0; i < n; ++i) {
+        double h = ws.impulse[i] * window_[i];
+        double t = i < causal ? static_cast<double>(i) : static_cast<double>(i) - static_cast<double>(n);
+        ws.impulse[i] = h;
+        ws.ramp[i] = t * h;
+    }
+    plan_->forward(ws.impulse.data(), ws.spectrum.data(), ws.work.data());
+    plan_->forward(ws.ramp.data(), ws.weighted.data(), ws.work.data());
+    std::size_t last_bin = std::min(bins - 1, static_cast<std::size_t>(max_freq_ / df));
+    double previous = 0.0, at_tuning = 0.0;
+    double tuning_bin = tuning / df;
+    for (std::size_t k = 1; k <= last_bin; ++k) {
+        double gd = previous;
+        if (std::norm(ws.spectrum[k]) > 1e-20) gd = (ws.weighted[k] / ws.spectrum[k]).real() * 1000.0 / sample_rate_;
+        if (gd > metrics.peak_group_delay) {
+            metrics.peak_group_delay = gd;
+            metrics.peak_group_delay_freq = k * df;
+        }
+        if (k - 1 < tuning_bin && tuning_bin <= k) at_tuning = previous + (gd - previous) * (tuning_bin - (k - 1));
+        if (curves) {
+            curves->freqs.push_back(k * df);
+            curves->group_delay.push_back(gd);
+        }
+        previous = gd;
+    }
+    metrics.group_delay_at_tuning = at_tuning;
+
+    return metrics;
+}
+
+}  // namespace speakerbox
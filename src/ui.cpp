@@ -1,4 +1,5 @@
 #include "ui.h"
+#include "plot.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -7,6 +8,10 @@
 #include <sys/ioctl.h>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <sstream>
+#include <algorithm>
 
 namespace speakerbox {
 
@@ -67,6 +72,7 @@ int UI::showMenu(const std::string& title, const std::vector<std::string>& optio
         if (key == 'A' || key == 'w' || key == 'i' || key == 'a') selected = (selected - 1 + options.size()) % options.size();  // Up
         else if (key == 'B' || key == 's' || key == 'k' || key == 'd') selected = (selected + 1) % options.size();  // Down
         else if (key == '\n' || key == '\r') return selected;
+        else if (key == kEndOfInput) break;
     }
     return -1;
 }
@@ -110,6 +116,128 @@ void UI::showProgress(int duration_ms) const {
 }
 
 void UI::displayResult(const EnclosureResult& result) const {
+    drawBox("Result", resultLines(result));
+    std::cout << "Press enter to continue..." << std::endl;
+    std::cin.get();
+}
+
+void UI::displayResult(const EnclosureResult& result, const TSParameters& params, const Sensitivity& sensitivity) const {
+    drawBox("Result", resultLines(result));
+    drawBox("Sensitivity (% per %)", sensitivityLines(result, params, sensitivity));
+    std::cout << "Press enter to continue..." << std::endl;
+    std::cin.get();
+}
+
+void UI::liveEdit(DesignModel& model) const {
+    const std::vector<std::string> types = {"Sealed", "Ported", "Bandpass", "Transmission Line", "Passive Radiator"};
+    const int fields = static_cast<int>(Parameter::Bl) + 1;
+    const int plot_row = 2, plot_col = 30;  // Plot sits right of the parameter list
+    // The other enclosure types, kept in sync for the compare overlay
+    Calculator calc;
+    std::vector<DesignModel> others;
+    for (std::size_t t = 0; t < types.size(); ++t) {
+        others.emplace_back(calc, model.params());
+        others.back().setType(static_cast<EnclosureType>(t));
+        others.back().update();
+    }
+    BraillePlot plot(45, 10, model.frequencies().front(), model.frequencies().back(), -30.0, 6.0);
+    bool compare = false;
+    int selected = 0;
+    std::string buffer;
+    unsigned nodes = model.update();
+    double frame_ms = 0.0;  // Key to flushed redraw, shown one frame late
+    auto start = std::chrono::steady_clock::now();
+    int term_rows = 0, term_cols = 0;
+    while (true) {
+        // A resize may have reflowed the screen: clear it and redraw every plot cell
+        int rows = 25, cols = 80;
+        terminalSize(rows, cols);
+        if (rows != term_rows || cols != term_cols) {
+            term_rows = rows;
+            term_cols = cols;
+            clearScreen();
+            std::cout << plot.frame(plot_row, plot_col);
+            plot.invalidate();
+        }
+
+        // Redraw in place from the home position; no full clear, so no flicker
+        std::ostringstream out;
+        out << "\033[H" << color("blue") << "┌─── Live Edit ───┐" << color("reset") << "\033[K\n";
+        for (int i = 0; i < fields; ++i) {
+            Parameter param = static_cast<Parameter>(i);
+            std::string value = (i == selected && !buffer.empty()) ? buffer + "_" : std::to_string(model.parameter(param));
+            std::string line = DesignModel::parameterName(param);
+            line.resize(12, ' ');
+            line = (i == selected ? "> " : "  ") + line + value;
+            line.resize(plot_col - 2, ' ');  // Pad instead of erasing into the plot
+            if (i == selected) out << color("inverse") << line << color("reset") << "\n";
+            else out << line << "\n";
+        }
+        // Every line below the plot is placed absolutely and clipped to the
+        // terminal, so nothing ever scrolls the plot away from its cells
+        const int first_row = plot_row + plot.rows() + 1;
+        const std::size_t width = static_cast<std::size_t>(std::max(term_cols - 3, 0));
+        std::vector<std::string> results = resultLines(model.result());
+        results.push_back("F3: " + std::to_string(model.f3()) + " Hz");
+        const int fixed = 3;  // Type, status and help lines
+        const std::size_t room = static_cast<std::size_t>(std::max(term_rows - first_row + 1 - fixed, 0));
+        if (results.size() > room) results.resize(room);
+        int row = first_row;
+        out << "\033[" << row++ << ";1H" << "Type: " << types[static_cast<int>(model.type())] << (compare ? "  (compare: all types)" : "") << "\033[K";
+        for (auto& line : results) {
+            if (line.size() > width) line.resize(width);
+            out << "\033[" << row++ << ";1H" << "│ " << line << "\033[K";
+        }
+        out << "\033[" << row++ << ";1H" << color("gray") << "Last frame: " << std::to_string(frame_ms) << " ms ["
+            << (nodes & DesignModel::Tuning ? "tuning " : "") << (nodes & DesignModel::Geometry ? "geometry " : "")
+            << (nodes & DesignModel::Transfer ? "transfer " : "") << (nodes & DesignModel::Response ? "response" : "") << "]" << color("reset")
+            << "\033[K";
+        out << "\033[" << row << ";1H" << "Arrows/enter: field  t: type  c: compare  q: quit\033[K";
+        if (row < term_rows) out << "\n\033[J";  // Erase what a longer result left below
+
+        plot.clear();
+        if (compare) {
+            for (std::size_t t = 0; t < others.size(); ++t) {
+                plot.plot(others[t].frequencies(), others[t].response(), static_cast<std::uint8_t>(2 + t));
+            }
+        }
+        plot.plot(model.frequencies(), model.response(), 1);
+        out << plot.render(plot_row, plot_col, palette());
+        std::cout << out.str() << std::flush;
+        frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        char key = getKey();
+        start = std::chrono::steady_clock::now();
+        if (key == 'q' || key == kEndOfInput) break;
+        if (key == 'A' || key == 'B' || key == '\n' || key == '\r') {
+            buffer.clear();
+            selected = (key == 'A' ? selected - 1 + fields : selected + 1) % fields;
+        } else if (key == 't') {
+            model.setType(static_cast<EnclosureType>((static_cast<int>(model.type()) + 1) % static_cast<int>(types.size())));
+        } else if (key == 'c') {
+            compare = !compare;
+        } else if (key == 127 || key == '\b') {
+            if (!buffer.empty()) buffer.pop_back();
+        } else if (std::isdigit(static_cast<unsigned char>(key)) || key == '.') {
+            buffer += key;
+        }
+        if (!buffer.empty()) {
+            char* end = nullptr;
+            double value = std::strtod(buffer.c_str(), &end);
+            if (*end == '\0') {
+                model.setParameter(static_cast<Parameter>(selected), value);
+                for (auto& other : others) other.setParameter(static_cast<Parameter>(selected), value);
+            }
+        }
+        nodes = model.update();
+        if (compare) {
+            for (auto& other : others) other.update();
+        }
+    }
+    clearScreen();
+}
+
+std::vector<std::string> UI::resultLines(const EnclosureResult& result) const {
     std::vector<std::string> content;
     content.push_back("Type: " + result.type);
     content.push_back("Vb: " + std::to_string(result.vb) + " L");
@@ -120,16 +248,42 @@ void UI::displayResult(const EnclosureResult& result) const {
         content.push_back("Port Diameter: " + std::to_string(result.port_diameter) + " cm");
         content.push_back("Air Velocity: " + std::to_string(result.air_velocity) + " m/s");
     }
-    content.push_back("Dimensions (WxHxD cm): " + std::to_string(result.width) + "x" + std::to_string(result.height) + "x" + std::to_string(result.depth));
+    content.push_back("Box (WxHxD cm): " + std::to_string(result.width) + "x" + std::to_string(result.height) + "x" + std::to_string(result.depth) +
+                      " inside, " + std::to_string(result.outer_width) + "x" + std::to_string(result.outer_height) + "x" +
+                      std::to_string(result.outer_depth) + " outside");
+    content.push_back("Displacement: " + std::to_string(result.displacement) + " L");
     content.push_back("Within Xmax: " + std::string(result.within_xmax ? "Yes" : "No"));
     if (!result.warnings.empty()) {
         for (const auto& w : result.warnings) {
             content.push_back("Warning: " + w);
         }
     }
-    drawBox("Result", content);
-    std::cout << "Press enter to continue..." << std::endl;
-    std::cin.get();
+    return content;
+}
+
+std::vector<std::string> UI::sensitivityLines(const EnclosureResult& result, const TSParameters& params, const Sensitivity& sensitivity) const {
+    const Sensitivity::Row* rows[] = {&sensitivity.vb, &sensitivity.fc_or_fb, &sensitivity.port_length,
+                                      &sensitivity.width, &sensitivity.height, &sensitivity.depth};
+    const double outputs[] = {result.vb, result.fc_or_fb, result.port_length, result.width, result.height, result.depth};
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "%-10s%7s%7s%7s%7s%7s%7s", "Param", "Vb", "Fc/Fb", "Port", "W", "H", "D");
+    std::vector<std::string> content = {buf};
+    for (std::size_t i = 0; i < kParameterCount; ++i) {
+        double value = params.*DesignModel::member(static_cast<Parameter>(i));
+        std::string line;
+        bool any = false;
+        for (std::size_t o = 0; o < 6; ++o) {
+            // Elasticity: relative change of the output per relative change of the parameter
+            double e = outputs[o] != 0.0 ? (*rows[o])[i] * value / outputs[o] : 0.0;
+            any = any || std::abs(e) > 1e-6;
+            std::snprintf(buf, sizeof(buf), "%7.2f", e);
+            line += buf;
+        }
+        if (!any) continue;
+        std::snprintf(buf, sizeof(buf), "%-10s", DesignModel::parameterName(static_cast<Parameter>(i)).c_str());
+        content.push_back(buf + line);
+    }
+    return content;
 }
 
 void UI::showHelp() const {
@@ -152,16 +306,30 @@ void UI::showError(const std::string& msg) const {
     std::cout << color("red") << "Error: " << msg << color("reset") << std::endl;
 }
 
-bool UI::checkTerminalSize() const {
+bool UI::terminalSize(int& rows, int& cols) const {
     struct winsize ws;
     if (ioctl(STDIN_FILENO, TIOCGWINSZ, &ws) == -1) return false;
-    if (ws.ws_col < 80 || ws.ws_row < 25) {
+    rows = ws.ws_row;
+    cols = ws.ws_col;
+    return true;
+}
+
+bool UI::checkTerminalSize() const {
+    int rows = 0, cols = 0;
+    if (!terminalSize(rows, cols)) return false;
+    if (cols < 80 || rows < 25) {
         showWarning("Terminal too small (min 80x25)");
         return false;
     }
     return true;
 }
 
+std::vector<std::string> UI::palette() const {
+    // Grid first, then one color per overlaid curve
+    if (!use_color_) return {};
+    return {color("gray"), color("yellow"), color("cyan"), color("green"), color("blue"), color("red"), color("white")};
+}
+
 std::string UI::color(const std::string& code) const {
     if (!use_color_) return "";
     auto it = colors_.find(code);
@@ -174,13 +342,10 @@ char UI::getKey() const {
     termios newt = oldt;
     newt.c_lflag &= ~(ICANON | ECHO);
     tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    char c = getchar();
-    if (c == '\033') {  // Escape
-        getchar();  // [
-        c = getchar();  // A/B/C/D for arrows
-    }
+    int c = getchar();
+    if (c == '\033' && getchar() != EOF) c = getchar();  // Escape [ then A/B/C/D for arrows
     tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    return c;
+    return c == EOF ? kEndOfInput : static_cast<char>(c);
 }
 
 }  // namespace speakerbox
@@ -1,8 +1,45 @@
 #include <gtest/gtest.h>
 #include "calculator.h"
+#include "model.h"
+#include "plot.h"
+#include "simulator.h"
+#include "transient.h"
+#include "render.h"
+#include "crossover.h"
+#include "directivity.h"
+#include "cutlist.h"
+#include "export.h"
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#ifdef SPEAKERBOX_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 namespace speakerbox {
 
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+template <typename T>
+T readRaw(const std::string& data, std::size_t& pos) {
+    T value{};
+    if (pos + sizeof(T) <= data.size()) std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+}  // namespace
+
 TEST(CalculatorTest, Sealed) {
     TSParameters params;
     params.fs = 30.0;
@@ -14,4 +51,662 @@ TEST(CalculatorTest, Sealed) {
     EXPECT_GT(res.vb, 0.0);
 }
 
+namespace {
+
+// Smallest max relative deviation between c and any member of the family
+double familyDistance(Alignment family, const alignment::Coefficients& c) {
+    double best = 1e9;
+    for (int i = 0; i <= 4000; ++i) {
+        alignment::Coefficients f = alignment::familyCoefficients(family, i / 4000.0);
+        double d = std::max({std::abs(f.a1 - c.a1) / f.a1, std::abs(f.a2 - c.a2) / f.a2, std::abs(f.a3 - c.a3) / f.a3});
+        best = std::min(best, d);
+    }
+    return best;
+}
+
+}  // namespace
+
+TEST(AlignmentTest, TablesMatchAlignmentEquations) {
+    for (std::size_t f = 0; f < alignment::kFamilies; ++f) {
+        Alignment family = static_cast<Alignment>(f);
+        for (std::size_t q = 0; q < alignment::kInvQL.size(); ++q) {
+            double inv_ql = alignment::kInvQL[q];
+            const alignment::Table& table = alignment::table(family, q);
+            for (std::size_t i = 0; i < alignment::kTableSize; i += 7) {
+                const AlignmentPoint& p = table.points[i];
+                alignment::Coefficients c = alignment::ventedCoefficients(p.qt, p.h, p.alpha, inv_ql);
+                EXPECT_LT(familyDistance(family, c), 2e-3) << alignmentName(family) << " QL index " << q << " entry " << i;
+            }
+        }
+    }
+}
+
+TEST(AlignmentTest, LosslessClosedForms) {
+    // B4: a1 = a3 = sqrt(4 + 2 sqrt(2)), a2 = 2 + sqrt(2) -> Qt = 0.3827, h = 1, alpha = sqrt(2)
+    AlignmentPoint b4 = alignment::table(Alignment::B4, 0).points[0];
+    EXPECT_NEAR(b4.qt, 1.0 / std::sqrt(4.0 + 2.0 * std::sqrt(2.0)), 1e-6);
+    EXPECT_NEAR(b4.h, 1.0, 1e-6);
+    EXPECT_NEAR(b4.alpha, std::sqrt(2.0), 1e-6);
+
+    // QB3 without losses: a1 = 1/(sqrt(h) Qt), a3 = sqrt(h)/Qt, a2 = a1^2/2, a3 = (a2^2 + 2)/(2 a1)
+    AlignmentPoint qb3 = lookupAlignment(Alignment::QB3, 0.3, 0.0);
+    double a1 = 1.0 / (std::sqrt(qb3.h) * 0.3);
+    double a2 = (qb3.alpha + 1.0 + qb3.h * qb3.h) / qb3.h;
+    double a3 = std::sqrt(qb3.h) / 0.3;
+    EXPECT_NEAR(a2, a1 * a1 / 2.0, 1e-3 * a2);
+    EXPECT_NEAR(a3, (a2 * a2 + 2.0) / (2.0 * a1), 1e-3 * a3);
+}
+
+TEST(CalculatorTest, PortedUsesAlignment) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.3827;
+    params.vas = 100.0;
+    Calculator calc;
+    EnclosureResult res = calc.calculate(params, EnclosureType::Ported, {{"alignment", static_cast<double>(Alignment::B4)}, {"ql", 0.0}});
+    EXPECT_NEAR(res.fc_or_fb, 30.0, 0.01);
+    EXPECT_NEAR(res.alpha, std::sqrt(2.0), 1e-3);
+    EXPECT_TRUE(res.warnings.empty());
+
+    // Out-of-range families fall back to the recommended one
+    EnclosureResult fallback = calc.calculate(params, EnclosureType::Ported, {{"alignment", 42.0}, {"ql", 0.0}});
+    EnclosureResult recommended = calc.calculate(params, EnclosureType::Ported, {{"ql", 0.0}});
+    EXPECT_DOUBLE_EQ(fallback.vb, recommended.vb);
+    ASSERT_EQ(fallback.warnings.size(), recommended.warnings.size() + 1);
+    EXPECT_EQ(fallback.warnings.back().rfind("Unknown alignment", 0), 0u);
+}
+
+TEST(CalculatorTest, FloatMatchesDouble) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.35;
+    params.vas = 50.0;
+    params.sd = 500.0;
+    params.xmax = 10.0;
+    params.vd = 0.5;
+    BasicTSParameters<float> single;
+    single.fs = 30.0f;
+    single.qts = 0.35f;
+    single.vas = 50.0f;
+    single.sd = 500.0f;
+    single.xmax = 10.0f;
+    single.vd = 0.5f;
+    Calculator calc;
+    for (EnclosureType type : {EnclosureType::Sealed, EnclosureType::Ported, EnclosureType::Bandpass}) {
+        EnclosureResult res = calc.calculate(params, type);
+        BasicEnclosureResult<float> low = calc.calculate(single, type);
+        EXPECT_EQ(low.type, res.type);
+        EXPECT_NEAR(low.vb, res.vb, 1e-4 * res.vb);
+        EXPECT_NEAR(low.fc_or_fb, res.fc_or_fb, 1e-4 * res.fc_or_fb);
+        EXPECT_NEAR(low.port_length, res.port_length, 1e-3 * res.port_length + 1e-4);
+        EXPECT_NEAR(low.width, res.width, 1e-4 * res.width);
+        EXPECT_NEAR(low.depth, res.depth, 1e-4 * res.depth);
+        EXPECT_EQ(low.warnings, res.warnings);
+    }
+}
+
+TEST(DesignModelTest, RecomputesOnlyAffectedNodes) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.4;
+    params.vas = 50.0;
+    Calculator calc;
+    DesignModel model(calc, params);
+    const unsigned all = DesignModel::Tuning | DesignModel::Geometry | DesignModel::Transfer | DesignModel::Response;
+    EXPECT_EQ(model.update(), all);
+    EXPECT_GT(model.f3(), 0.0);
+
+    model.setParameter(Parameter::Re, 6.0);
+    EXPECT_EQ(model.update(), 0u);
+
+    // Displacement and cabinet build only move the dimensions
+    model.setParameter(Parameter::Vd, 0.2);
+    EXPECT_EQ(model.update(), static_cast<unsigned>(DesignModel::Geometry));
+    model.setOption("panel", 12.0);
+    EXPECT_EQ(model.update(), static_cast<unsigned>(DesignModel::Geometry));
+    EnclosureResult full = calc.calculate(model.params(), EnclosureType::Sealed, {{"panel", 12.0}});
+    EXPECT_DOUBLE_EQ(model.result().width, full.width);
+    EXPECT_DOUBLE_EQ(model.result().outer_depth, full.outer_depth);
+    EXPECT_EQ(model.result().warnings, full.warnings);
+
+    // A sealed box keeps its Qtc, so Vas moves Vb but not the response
+    model.setParameter(Parameter::Vas, 60.0);
+    EXPECT_EQ(model.update(), DesignModel::Tuning | DesignModel::Geometry);
+
+    model.setParameter(Parameter::Fs, 32.0);
+    EXPECT_EQ(model.update(), all);
+    EXPECT_NEAR(model.result().fc_or_fb, calc.calculate(model.params(), EnclosureType::Sealed).fc_or_fb, 1e-9);
+}
+
+TEST(BraillePlotTest, MapsDotsAndRedrawsOnlyChangedCells) {
+    // One row of four cells, 8 x 4 dots, no decade inside 20-80 Hz so the grid is the top-row dots every 4 px
+    BraillePlot plot(4, 1, 20.0, 80.0, -10.0, 10.0);
+    auto cell = [](int bits) {
+        return std::string{static_cast<char>(0xE2), static_cast<char>(0xA0 | (bits >> 6)), static_cast<char>(0x80 | (bits & 0x3F))};
+    };
+    const std::string at = "\033[1;6H";  // Row 1, past the dB labels
+    EXPECT_EQ(plot.render(1, 1, {}), at + cell(0x01) + "\033[1;8H" + cell(0x01));
+    EXPECT_EQ(plot.render(1, 1, {}), "");
+
+    // Bottom dot row: left column is bit 0x40, right column 0x80
+    plot.plot({20.0, 80.0}, {-10.0, -10.0}, 1);
+    const std::string line = at + cell(0xC1) + cell(0xC0) + cell(0xC1) + cell(0xC0);
+    EXPECT_EQ(plot.render(1, 1, {}), line);
+    EXPECT_EQ(plot.render(1, 1, {}), "");
+    plot.invalidate();
+    EXPECT_EQ(plot.render(1, 1, {}), line);
+
+    // Clearing leaves the grid; the blank cells are written out too
+    plot.clear();
+    EXPECT_EQ(plot.render(1, 1, {}), at + cell(0x01) + cell(0x00) + cell(0x01) + cell(0x00));
+
+    // A single dot on the right column of the second cell, one row up, in palette color 1
+    plot.plot({20.0 * std::pow(4.0, 3.0 / 7.0), 20.0 * std::pow(4.0, 3.0 / 7.0)}, {10.0 - 20.0 * 2.0 / 3.0, 10.0 - 20.0 * 2.0 / 3.0}, 1);
+    EXPECT_EQ(plot.render(1, 1, {"<g>", "<c>"}), "\033[1;7H<c>" + cell(0x20) + "\033[0m");
+}
+
+TEST(SimulatorTest, SmallSignalMatchesTransferFunction) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.4;
+    params.vas = 50.0;
+    params.re = 6.0;
+    params.sd = 500.0;
+    params.xmax = 10.0;
+    Calculator calc;
+    EnclosureResult res = calc.calculate(params, EnclosureType::Sealed);
+    TransferFunction tf = calc.transferFunction(params, res);
+    Simulator sim(params, res);
+    ASSERT_TRUE(sim.ok());
+
+    std::vector<DistortionResult> out = sim.run(Simulator::sweep({40.0, 160.0}, {0.1, 30.0}));
+    ASSERT_EQ(out.size(), 4u);
+    double linear = 20.0 * std::log10(std::abs(tf.evaluate(160.0)) / std::abs(tf.evaluate(40.0)));
+    EXPECT_NEAR(out[1].spl - out[0].spl, linear, 0.25);  // Le = 0, as in the transfer function
+    EXPECT_LT(out[0].thd, 0.1);
+    // Large excursion at 40 Hz distorts and compresses
+    EXPECT_GT(out[2].thd, 10.0 * out[0].thd);
+    EXPECT_GT(out[2].compression, 0.0);
+}
+
+TEST(FftTest, MatchesDirectTransform) {
+    // Powers of two and mixed radices, including a prime half length
+    for (std::size_t n : {2u, 8u, 12u, 30u, 64u, 126u, 194u, 1000u}) {
+        FftPlan plan(n);
+        std::vector<double> x(n), y(n);
+        for (std::size_t i = 0; i < n; ++i) x[i] = std::sin(0.7 * i * i + 0.3) + 0.1 * i;
+        std::vector<std::complex<double>> spectrum(plan.bins()), work(plan.workSize());
+        plan.forward(x.data(), spectrum.data(), work.data());
+        for (std::size_t k = 0; k < plan.bins(); ++k) {
+            std::complex<double> expected = 0.0;
+            for (std::size_t i = 0; i < n; ++i) expected += x[i] * std::polar(1.0, -2.0 * PI * static_cast<double>((i * k) % n) / n);
+            EXPECT_NEAR(std::abs(spectrum[k] - expected), 0.0, 1e-9) << "n=" << n << " k=" << k;
+        }
+        plan.inverse(spectrum.data(), y.data(), work.data());
+        for (std::size_t i = 0; i < n; ++i) EXPECT_NEAR(y[i], x[i], 1e-12) << "n=" << n;
+    }
+}
+
+TEST(TransientTest, GroupDelayMatchesPhaseSlope) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.4;
+    params.vas = 50.0;
+    Calculator calc;
+    TransientAnalyzer analyzer;
+    for (EnclosureType type : {EnclosureType::Sealed, EnclosureType::Ported}) {
+        EnclosureResult res = calc.calculate(params, type);
+        TransferFunction tf = calc.transferFunction(params, res);
+        double df = 0.01;
+        double dphase = std::arg(tf.evaluate(res.fc_or_fb + df) / tf.evaluate(res.fc_or_fb - df));
+        double expected = -dphase / (2.0 * PI * 2.0 * df) * 1000.0;
+        TransientResult tr = analyzer.analyze(tf, res.fc_or_fb);
+        EXPECT_NEAR(tr.metrics.group_delay_at_tuning, expected, 0.05 * expected);
+        EXPECT_GT(tr.metrics.decay_time, 0.0);
+    }
+    // A vented box rings longer than a sealed one
+    std::vector<EnclosureResult> results = {calc.calculate(params, EnclosureType::Sealed), calc.calculate(params, EnclosureType::Ported)};
+    std::vector<TransientMetrics> metrics = analyzer.analyzeBatch(calc, {params, params}, results);
+    EXPECT_GT(metrics[1].decay_time, metrics[0].decay_time);
+    EXPECT_GT(metrics[1].step_undershoot, metrics[0].step_undershoot);
+}
+
+TEST(RenderTest, BiquadsMatchAnalogResponse) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.4;
+    params.vas = 50.0;
+    Calculator calc;
+    const double rate = 48000.0;
+    for (EnclosureType type : {EnclosureType::Sealed, EnclosureType::Ported, EnclosureType::Bandpass}) {
+        EnclosureResult res = calc.calculate(params, type);
+        TransferFunction tf = calc.transferFunction(params, res);
+        std::vector<Biquad> sections = designBiquads(tf, rate, res.fc_or_fb);
+        ASSERT_EQ(sections.size(), (tf.den.size() - 1) / 2);
+        for (double f : {10.0, res.fc_or_fb, 200.0, 2000.0}) {
+            std::complex<double> z = std::polar(1.0, -2.0 * PI * f / rate), h = 1.0;
+            for (const Biquad& q : sections) h *= (q.b0 + q.b1 * z + q.b2 * z * z) / (1.0 + q.a1 * z + q.a2 * z * z);
+            // Prewarped at the tuning, where the match is exact
+            double tolerance = f == res.fc_or_fb ? 1e-9 : 0.01;
+            EXPECT_NEAR(std::abs(h), std::abs(tf.evaluate(f)), tolerance) << res.type << " " << f << " Hz";
+        }
+    }
+}
+
+TEST(SensitivityTest, MatchesFiniteDifferences) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.35;
+    params.vas = 50.0;
+    params.re = 6.0;
+    params.sd = 500.0;
+    params.xmax = 10.0;
+    params.vd = 0.5;
+    Calculator calc;
+    double TSParameters::*fields[kParameterCount] = {&TSParameters::fs, &TSParameters::qts, &TSParameters::vas, &TSParameters::re,
+                                                     &TSParameters::sd, &TSParameters::xmax, &TSParameters::vd, &TSParameters::le,
+                                                     &TSParameters::cms, &TSParameters::mms, &TSParameters::bl};
+    for (EnclosureType type : {EnclosureType::Sealed, EnclosureType::Ported, EnclosureType::Bandpass}) {
+        Sensitivity sens;
+        EnclosureResult res = calc.calculateSensitivity(params, type, sens);
+        EnclosureResult plain = calc.calculate(params, type);
+        EXPECT_DOUBLE_EQ(res.vb, plain.vb);
+        EXPECT_DOUBLE_EQ(res.port_length, plain.port_length);
+        for (std::size_t i = 0; i < kParameterCount; ++i) {
+            double step = 1e-6 * std::max(1.0, params.*fields[i]);
+            TSParameters up = params, down = params;
+            up.*fields[i] += step;
+            down.*fields[i] -= step;
+            EnclosureResult a = calc.calculate(up, type), b = calc.calculate(down, type);
+            EXPECT_NEAR(sens.vb[i], (a.vb - b.vb) / (2.0 * step), 1e-4 * (1.0 + std::abs(sens.vb[i]))) << res.type << " vb/" << i;
+            EXPECT_NEAR(sens.fc_or_fb[i], (a.fc_or_fb - b.fc_or_fb) / (2.0 * step), 1e-4 * (1.0 + std::abs(sens.fc_or_fb[i]))) << res.type << " fb/" << i;
+            EXPECT_NEAR(sens.port_length[i], (a.port_length - b.port_length) / (2.0 * step), 1e-4 * (1.0 + std::abs(sens.port_length[i])))
+                << res.type << " port/" << i;
+            EXPECT_NEAR(sens.width[i], (a.width - b.width) / (2.0 * step), 1e-4 * (1.0 + std::abs(sens.width[i]))) << res.type << " width/" << i;
+        }
+    }
+}
+
+TEST(CrossoverTest, SynthesisMatchesTargetAndFitsPreferredValues) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.4;
+    params.vas = 50.0;
+    params.re = 6.0;
+    params.sd = 500.0;
+    params.xmax = 10.0;
+    Calculator calc;
+    EnclosureResult res = calc.calculate(params, EnclosureType::Sealed);
+    Crossover crossover(params, res);
+    ASSERT_TRUE(crossover.ok());
+
+    // LR4 prototype 1.8856, 1.5910, 0.9428, 0.3536 scaled to Re and w0
+    CrossoverTarget target;
+    target.frequency = 3000.0;
+    target.level = -3.0;
+    CrossoverDesign design = crossover.design(target);
+    const double w0 = 2.0 * PI * target.frequency;
+    ASSERT_EQ(design.ladder.size(), 4u);
+    EXPECT_NEAR(design.ladder[0], 4.0 * std::sqrt(2.0) / 3.0 * params.re / w0, 1e-9);
+    EXPECT_NEAR(design.ladder[1], 9.0 / (4.0 * std::sqrt(2.0)) / (params.re * w0), 1e-9);
+    EXPECT_NEAR(design.ladder[2], 2.0 * std::sqrt(2.0) / 3.0 * params.re / w0, 1e-9);
+    EXPECT_NEAR(design.ladder[3], 1.0 / (2.0 * std::sqrt(2.0)) / (params.re * w0), 1e-9);
+    EXPECT_EQ(design.zobel_r, 0.0);  // Le = 0
+
+    // Far above resonance the coil is close to Re, so the textbook network lands on target
+    CrossoverResponse response = crossover.simulate(design);
+    std::vector<double> wanted = crossover.targetCurve(target);
+    for (std::size_t k = 0; k < wanted.size(); ++k) {
+        if (crossover.freqs()[k] > 500.0 && wanted[k] > -40.0) {
+            EXPECT_NEAR(response.spl[k], wanted[k], 0.3) << crossover.freqs()[k] << " Hz";
+        }
+    }
+
+    CrossoverOptimization opt = crossover.optimize(target);
+    EXPECT_LE(opt.error, opt.nominal_error + 0.5);
+    for (double value : opt.design.ladder) EXPECT_DOUBLE_EQ(value, preferredValue(value, ESeries::E12));
+    EXPECT_DOUBLE_EQ(opt.design.pad_series, preferredValue(opt.design.pad_series, ESeries::E24));
+    EXPECT_DOUBLE_EQ(opt.design.pad_shunt, preferredValue(opt.design.pad_shunt, ESeries::E24));
+}
+
+TEST(DirectivityTest, BaffleStepAndPistonLimits) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.4;
+    params.vas = 50.0;
+    params.re = 6.0;
+    params.sd = 500.0;
+    params.xmax = 10.0;
+    Calculator calc;
+    EnclosureResult res = calc.calculate(params, EnclosureType::Sealed);
+    DirectivityModel model;
+    PolarMap map = model.compute(params, res);
+    ASSERT_EQ(map.spl.size(), map.freqs.size() * map.angles.size());
+
+    // Below the baffle step the box radiates into full space: 6 dB down and no directivity
+    EXPECT_NEAR(map.at(0, 0), -6.02, 0.3);
+    EXPECT_NEAR(map.di[0], 0.0, 0.3);
+
+    // Far above it the edge sources fade and the cone is a baffled piston
+    const double a = std::sqrt(params.sd * 1e-4 / PI);
+    std::size_t i = 0;
+    while (2.0 * PI * map.freqs[i + 1] / 343.0 * a < 10.0) ++i;
+    const double ka = 2.0 * PI * map.freqs[i] / 343.0 * a;
+    const std::size_t j = static_cast<std::size_t>(std::lround(10.0 / (180.0 / (map.angles.size() - 1))));
+    const double x = ka * std::sin(map.angles[j] * PI / 180.0);
+    EXPECT_NEAR(map.at(i, j) - map.at(i, 0), 20.0 * std::log10(std::abs(2.0 * std::cyl_bessel_j(1.0, x) / x)), 0.1);
+    EXPECT_NEAR(map.di[i], 10.0 * std::log10(ka * ka / (1.0 - std::cyl_bessel_j(1.0, 2.0 * ka) / ka)), 0.5);
+
+    // A reversed or non-positive band builds no grid and maps nothing
+    for (auto band : {std::make_pair(0.0, 1000.0), std::make_pair(1000.0, 100.0)}) {
+        DirectivityModel bad(200, 180, band.first, band.second);
+        EXPECT_FALSE(bad.ok());
+        EXPECT_TRUE(bad.compute(params, res).spl.empty());
+        EXPECT_EQ(bad.analyzeBatch({params}, {res})[0].di_1k, 0.0);
+    }
+
+    // No step where the cone's direct sound goes into the shadow behind the baffle
+    DirectivityModel fine(200, 361);
+    PolarMap polar = fine.compute(params, res);
+    ASSERT_DOUBLE_EQ(polar.angles[179], 89.5);
+    ASSERT_DOUBLE_EQ(polar.angles[181], 90.5);
+    for (double target : {0.5, 1.0, 2.0, 5.0, 10.0, 20.0}) {
+        i = 0;
+        while (2.0 * PI * polar.freqs[i + 1] / 343.0 * a < target) ++i;
+        EXPECT_NEAR(polar.at(i, 179), polar.at(i, 181), 1.0) << "ka " << target;
+    }
+}
+
+TEST(CabinetTest, SolvesNetVolumeWithinLimits) {
+    CabinetConstraints c;
+    BasicCabinet<double> box = solveCabinet(40.0, 2.0, 25.0, c);
+    ASSERT_TRUE(box.fits);
+    EXPECT_NEAR(box.width * box.height * box.depth / 1000.0 - box.bracing, 42.0, 1e-9);
+    EXPECT_NEAR(box.height / box.width, c.ratio_height / c.ratio_width, 1e-9);
+    EXPECT_NEAR(box.outer_depth - box.depth, 2.0 * c.panel / 10.0, 1e-12);
+    // Window brace: 5 cm rails, 1.8 cm thick
+    EXPECT_NEAR(box.bracing, 1.8 * (box.width * box.depth - (box.width - 10.0) * (box.depth - 10.0)) / 1000.0, 1e-12);
+
+    // A height limit moves the volume into width and depth; the cutout holds the baffle width
+    c.max_height = 50.0;
+    box = solveCabinet(40.0, 2.0, 30.0, c);
+    ASSERT_TRUE(box.fits);
+    EXPECT_NEAR(box.outer_height, 50.0, 1e-9);
+    EXPECT_NEAR(box.width * box.height * box.depth / 1000.0 - box.bracing, 42.0, 1e-9);
+    EXPECT_GE(box.width, 30.0);
+    c.max_width = c.max_depth = 30.0;
+    EXPECT_FALSE(solveCabinet(40.0, 2.0, 20.0, c).fits);
+
+    // A cutout wider than the widest baffle pins the width at its maximum; the volume still comes out exact
+    CabinetConstraints narrow;
+    narrow.max_width = 25.0;
+    box = solveCabinet(50.0, 2.0, 30.0, narrow);
+    EXPECT_TRUE(box.fits);
+    EXPECT_FALSE(box.baffle_fits);
+    EXPECT_NEAR(box.outer_width, 25.0, 1e-9);
+    EXPECT_NEAR(box.width * box.height * box.depth / 1000.0 - box.bracing, 52.0, 1e-9);
+
+    // A limit thinner than two panels leaves no box to size
+    CabinetConstraints thin;
+    thin.max_depth = 3.0;
+    box = solveCabinet(40.0, 2.0, 20.0, thin);
+    EXPECT_FALSE(box.fits);
+    EXPECT_EQ(box.width, 0.0);
+    EXPECT_EQ(box.depth, 0.0);
+
+    // Through the calculator: limits come from the options, Vb stays the net air volume
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.4;
+    params.vas = 50.0;
+    params.sd = 500.0;
+    params.vd = 0.5;
+    Calculator calc;
+    EnclosureResult res = calc.calculate(params, EnclosureType::Sealed, {{"max_height", 40.0}, {"braces", 2.0}});
+    EXPECT_NEAR(res.outer_height, 40.0, 1e-9);
+    EXPECT_NEAR(res.width * res.height * res.depth / 1000.0 - res.displacement, res.vb, 1e-9);
+}
+
+TEST(CutListTest, PanelsStayOnSheetsWithoutOverlap) {
+    std::vector<Panel> panels;
+    CabinetConstraints c;
+    for (std::size_t i = 0; i < 40; ++i) {
+        BasicCabinet<double> box = solveCabinet(20.0 + i, 1.0, 20.0, c);
+        EnclosureResult res{};
+        res.width = box.width;
+        res.depth = box.depth;
+        res.outer_width = box.outer_width;
+        res.outer_height = box.outer_height;
+        res.outer_depth = box.outer_depth;
+        std::vector<Panel> box_panels = cabinetPanels(res, c, i);
+        ASSERT_EQ(box_panels.size(), 7u);
+        panels.insert(panels.end(), box_panels.begin(), box_panels.end());
+    }
+    CutListOptions options;
+    options.attempts = 32;
+    CutList list = CutListOptimizer(options).optimize(panels);
+    ASSERT_TRUE(list.unplaced.empty());
+    ASSERT_EQ(list.placements.size(), panels.size());
+
+    double area = 0.0;
+    for (const Panel& p : panels) area += p.width * p.height;
+    const double sheet = options.sheet_width * options.sheet_height;
+    EXPECT_GE(list.sheets, static_cast<std::size_t>(std::ceil(area / sheet)));
+    EXPECT_NEAR(list.waste, 1.0 - area / (list.sheets * sheet), 1e-12);
+
+    // Kerf-wide gaps between panels, trim clear of the edges
+    auto extent = [&](const Placement& pl, double& w, double& h) {
+        w = pl.rotated ? panels[pl.panel].height : panels[pl.panel].width;
+        h = pl.rotated ? panels[pl.panel].width : panels[pl.panel].height;
+    };
+    for (std::size_t i = 0; i < list.placements.size(); ++i) {
+        const Placement& a = list.placements[i];
+        double aw, ah;
+        extent(a, aw, ah);
+        EXPECT_LT(a.sheet, list.sheets);
+        EXPECT_GE(a.x, options.trim);
+        EXPECT_GE(a.y, options.trim);
+        EXPECT_LE(a.x + aw, options.sheet_width - options.trim + 1e-9);
+        EXPECT_LE(a.y + ah, options.sheet_height - options.trim + 1e-9);
+        for (std::size_t j = i + 1; j < list.placements.size() && list.placements[j].sheet == a.sheet; ++j) {
+            const Placement& b = list.placements[j];
+            double bw, bh;
+            extent(b, bw, bh);
+            bool apart = a.x + aw + options.kerf <= b.x + 1e-9 || b.x + bw + options.kerf <= a.x + 1e-9 ||
+                         a.y + ah + options.kerf <= b.y + 1e-9 || b.y + bh + options.kerf <= a.y + 1e-9;
+            EXPECT_TRUE(apart) << "panels " << a.panel << " and " << b.panel;
+        }
+    }
+
+    // Fixed attempts, same answer on any thread count
+    for (std::size_t workers : {1, 3, 32}) {
+        options.workers = workers;
+        CutList again = CutListOptimizer(options).optimize(panels);
+        EXPECT_EQ(again.sheets, list.sheets) << workers << " workers";
+        EXPECT_EQ(again.smallest_fill, list.smallest_fill) << workers << " workers";
+        ASSERT_EQ(again.placements.size(), list.placements.size());
+        for (std::size_t i = 0; i < list.placements.size(); ++i) {
+            EXPECT_EQ(again.placements[i].panel, list.placements[i].panel);
+            EXPECT_EQ(again.placements[i].sheet, list.placements[i].sheet);
+            EXPECT_EQ(again.placements[i].x, list.placements[i].x);
+            EXPECT_EQ(again.placements[i].y, list.placements[i].y);
+            EXPECT_EQ(again.placements[i].rotated, list.placements[i].rotated);
+        }
+    }
+}
+
+TEST(ExportTest, RoundTripsEveryFormat) {
+    TSParameters params;
+    params.fs = 30.0;
+    params.qts = 0.4;
+    params.vas = 50.0;
+    params.sd = 500.0;
+    params.vd = 0.5;
+    Calculator calc;
+    std::vector<EnclosureResult> batch = {calc.calculate(params, EnclosureType::Sealed), calc.calculate(params, EnclosureType::Ported)};
+    batch[1].warnings.push_back("quote \" and, comma");
+    const std::string dir = (std::filesystem::temp_directory_path() / "speakerbox_export_test").string();
+    std::filesystem::create_directories(dir);
+    // Numeric columns in file order
+    const std::vector<std::pair<std::string, double EnclosureResult::*>> columns = {
+        {"vb", &EnclosureResult::vb}, {"fc_or_fb", &EnclosureResult::fc_or_fb}, {"port_length", &EnclosureResult::port_length},
+        {"port_diameter", &EnclosureResult::port_diameter}, {"air_velocity", &EnclosureResult::air_velocity}, {"alpha", &EnclosureResult::alpha},
+        {"ql", &EnclosureResult::ql}, {"width", &EnclosureResult::width}, {"height", &EnclosureResult::height}, {"depth", &EnclosureResult::depth},
+        {"outer_width", &EnclosureResult::outer_width}, {"outer_height", &EnclosureResult::outer_height},
+        {"outer_depth", &EnclosureResult::outer_depth}, {"displacement", &EnclosureResult::displacement}};
+    auto write = [&](const std::string& name, ExportFormat format, bool compress) {
+        ResultExporter exporter(dir + "/" + name, format, compress);
+        exporter.write(batch);
+        exporter.close();
+        EXPECT_TRUE(exporter.ok()) << name;
+        EXPECT_EQ(exporter.rows(), batch.size());
+        return exporter.compressed();
+    };
+
+    // CSV: shortest round-trip numbers, the warnings field quoted with doubled quotes
+    write("r.csv", ExportFormat::Csv, false);
+    const std::string csv = readFile(dir + "/r.csv");
+    std::istringstream lines(csv);
+    std::string line, header = "type";
+    for (const auto& column : columns) header += "," + column.first;
+    ASSERT_TRUE(std::getline(lines, line));
+    EXPECT_EQ(line, header + ",within_xmax,warnings");
+    for (const auto& res : batch) {
+        ASSERT_TRUE(std::getline(lines, line));
+        std::vector<std::string> fields;
+        std::size_t start = 0;
+        for (std::size_t i = 0; i < columns.size() + 2; ++i) {
+            std::size_t comma = line.find(',', start);
+            ASSERT_NE(comma, std::string::npos);
+            fields.push_back(line.substr(start, comma - start));
+            start = comma + 1;
+        }
+        EXPECT_EQ(fields[0], res.type);
+        for (std::size_t c = 0; c < columns.size(); ++c) EXPECT_EQ(std::stod(fields[c + 1]), res.*columns[c].second) << columns[c].first;
+        EXPECT_EQ(fields.back(), res.within_xmax ? "1" : "0");
+        if (res.warnings.empty()) {
+            EXPECT_EQ(line.substr(start), "");
+        }
+    }
+    const std::string quoted = "quote \"\" and, comma\"";
+    EXPECT_EQ(line.substr(line.size() - quoted.size()), quoted);
+    EXPECT_FALSE(std::getline(lines, line));
+
+    // gzip holds the same bytes; without zlib the exporter falls back to plain text
+    bool compressed = write("r.csv.gz", ExportFormat::Csv, true);
+    std::string unpacked = readFile(dir + "/r.csv.gz");
+#ifdef SPEAKERBOX_HAVE_ZLIB
+    ASSERT_TRUE(compressed);
+    gzFile gz = gzopen((dir + "/r.csv.gz").c_str(), "rb");
+    ASSERT_NE(gz, nullptr);
+    unpacked.assign(csv.size() + 1, '\0');
+    unpacked.resize(std::max(gzread(gz, &unpacked[0], static_cast<unsigned>(unpacked.size())), 0));
+    gzclose(gz);
+#else
+    EXPECT_FALSE(compressed);
+#endif
+    EXPECT_EQ(unpacked, csv);
+
+    // JSON Lines: one object per row, escaped strings
+    write("r.jsonl", ExportFormat::JsonLines, false);
+    std::istringstream json(readFile(dir + "/r.jsonl"));
+    for (const auto& res : batch) {
+        ASSERT_TRUE(std::getline(json, line));
+        EXPECT_EQ(line.rfind("{\"type\":\"" + res.type + "\",", 0), 0u);
+        for (const auto& column : columns) {
+            std::size_t at = line.find("\"" + column.first + "\":");
+            ASSERT_NE(at, std::string::npos) << column.first;
+            EXPECT_EQ(std::strtod(line.c_str() + at + column.first.size() + 3, nullptr), res.*column.second) << column.first;
+        }
+        EXPECT_NE(line.find(res.within_xmax ? "\"within_xmax\":true" : "\"within_xmax\":false"), std::string::npos);
+    }
+    EXPECT_NE(line.find("\"quote \\\" and, comma\"]}"), std::string::npos);
+
+    // SBXC: header, one batch of columns, empty footer batch
+    write("r.sbxc", ExportFormat::Columnar, false);
+    const std::string sbxc = readFile(dir + "/r.sbxc");
+    ASSERT_EQ(sbxc.compare(0, 4, "SBXC"), 0);
+    std::size_t pos = 4;
+    EXPECT_EQ(readRaw<std::uint32_t>(sbxc, pos), 1u);
+    ASSERT_EQ(readRaw<std::uint32_t>(sbxc, pos), columns.size() + 3);
+    std::vector<std::pair<int, std::string>> names;
+    for (std::size_t c = 0; c < columns.size() + 3; ++c) {
+        int kind = readRaw<unsigned char>(sbxc, pos);
+        std::size_t size = readRaw<std::uint16_t>(sbxc, pos);
+        names.emplace_back(kind, sbxc.substr(pos, size));
+        pos += size;
+    }
+    EXPECT_EQ(names.front(), std::make_pair(1, std::string("type")));
+    for (std::size_t c = 0; c < columns.size(); ++c) EXPECT_EQ(names[c + 1], std::make_pair(0, columns[c].first));
+    EXPECT_EQ(names[columns.size() + 1], std::make_pair(1, std::string("within_xmax")));
+    EXPECT_EQ(names.back(), std::make_pair(2, std::string("warnings")));
+    ASSERT_EQ(readRaw<std::uint32_t>(sbxc, pos), batch.size());
+    EXPECT_EQ(readRaw<unsigned char>(sbxc, pos), static_cast<unsigned char>(EnclosureType::Sealed));
+    EXPECT_EQ(readRaw<unsigned char>(sbxc, pos), static_cast<unsigned char>(EnclosureType::Ported));
+    for (const auto& column : columns) {
+        for (const auto& res : batch) EXPECT_EQ(readRaw<double>(sbxc, pos), res.*column.second) << column.first;
+    }
+    for (const auto& res : batch) EXPECT_EQ(readRaw<unsigned char>(sbxc, pos), res.within_xmax ? 1 : 0);
+    std::vector<std::uint32_t> offsets;
+    for (std::size_t i = 0; i <= batch.size(); ++i) offsets.push_back(readRaw<std::uint32_t>(sbxc, pos));
+    const std::string text = sbxc.substr(pos, offsets.back());
+    pos += offsets.back();
+    EXPECT_EQ(text.substr(offsets[1]).substr(text.size() - offsets[1] - 18), "quote \" and, comma");
+    EXPECT_EQ(readRaw<std::uint32_t>(sbxc, pos), 0u);
+    EXPECT_EQ(pos, sbxc.size());
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ExportTest, BlockWriterAndParameterReader) {
+    const std::string dir = (std::filesystem::temp_directory_path() / "speakerbox_block_test").string();
+    std::filesystem::create_directories(dir);
+    // Blocks far smaller than the output, so the writer thread swaps hundreds of times
+    std::string expected;
+    {
+        BlockWriter writer(dir + "/b.txt", 64);
+        ASSERT_TRUE(writer.ok());
+        for (int i = 0; i < 1000; ++i) {
+            std::string chunk = std::to_string(i) + ",";
+            writer.block() += chunk;
+            writer.commit();
+            expected += chunk;
+        }
+        writer.close();
+        EXPECT_TRUE(writer.ok());
+    }
+    EXPECT_EQ(readFile(dir + "/b.txt"), expected);
+
+    // A writer that never opened drops its blocks instead of waiting on a thread it never started
+    BlockWriter dead(dir + "/missing/b.txt", 4);
+    EXPECT_FALSE(dead.ok());
+    for (int i = 0; i < 3; ++i) {
+        dead.block() += "0123456789";
+        dead.commit();
+    }
+    dead.flush();
+    dead.close();
+    ResultExporter exporter(dir + "/missing/r.csv", ExportFormat::Csv);
+    exporter.write(std::vector<EnclosureResult>(3));
+    exporter.close();
+    EXPECT_FALSE(exporter.ok());
+    std::filesystem::remove_all(dir);
+
+    // Header order is free, unknown columns and blank lines are skipped, empty fields stay zero
+    std::istringstream csv("fs, qts,notes,vas\n30,0.4,x,50\n\n 31,0.5,,\n");
+    TSParametersReader reader(csv);
+    ASSERT_TRUE(reader.ok());
+    std::vector<TSParameters> rows;
+    ASSERT_EQ(reader.read(rows, 1), 1u);
+    EXPECT_EQ(rows[0].fs, 30.0);
+    EXPECT_EQ(rows[0].qts, 0.4);
+    EXPECT_EQ(rows[0].vas, 50.0);
+    ASSERT_EQ(reader.read(rows, 10), 1u);
+    EXPECT_EQ(rows[0].fs, 31.0);
+    EXPECT_EQ(rows[0].qts, 0.5);
+    EXPECT_EQ(rows[0].vas, 0.0);
+    EXPECT_EQ(reader.read(rows, 10), 0u);
+    std::istringstream unknown("a,b\n1,2\n");
+    EXPECT_FALSE(TSParametersReader(unknown).ok());
+}
+
 }  // namespace speakerbox